@@ -0,0 +1,28 @@
+#!/bin/bash
+# Time trials of the triangle example under each executor protocol: spawn,
+# persistent, and zygote. Trials run one at a time, so the time per trial is
+# mostly the cost of launching the executor, plus its few microseconds of
+# work.
+#
+# usage: examples/bench_launch.sh [TRIALS]   (run from the repository root)
+
+set -e
+
+trials=${1:-500}
+runner=${RUNNER:-bin/runner}
+
+if [ ! -x "$runner" ]; then
+  echo "$runner not found; build it first, or set RUNNER" >&2
+  exit 1
+fi
+
+printf "%-22s %8s %10s %12s\n" experiment trials seconds "ms/trial"
+for exp in triangles triangles_persistent triangles_zygote; do
+  file=examples/${exp/triangles/triangle}.experiment.json
+  start=$(date +%s.%N)
+  "$runner" -f "$file" -x "$exp" -R "$trials" -J 1 -l 2 > /dev/null
+  end=$(date +%s.%N)
+  awk -v e="$exp" -v n="$trials" -v s="$start" -v t="$end" 'BEGIN {
+    printf "%-22s %8d %10.2f %12.3f\n", e, n, t - s, (t - s) * 1000 / n
+  }'
+done
@@ -0,0 +1,130 @@
+"""Helpers for writing Royale SMC experiment executors in Python.
+
+Call main() with a function taking a Job Input dict and returning a Job
+Output dict; main() speaks whichever protocol and transport the runner asked
+for, and runs batches one Job at a time.
+"""
+import array
+import json
+import os
+import selectors
+import signal
+import socket
+import sys
+
+def run_item(run, i):
+    try:
+        return run(i)
+    except Exception as e:
+        return {"error": str(e)}
+
+def read_input():
+    fd = os.environ.get("ROYALE_INPUT_FD")
+    if fd is None:
+        return sys.stdin.read()
+    # The memfd transport; see transport
+    with os.fdopen(int(fd), "rb", closefd=False) as f:
+        f.seek(0)
+        return f.read().decode()
+
+def write_output(o):
+    fd = os.environ.get("ROYALE_OUTPUT_FD")
+    if fd is None:
+        print(json.dumps(o))
+        sys.stdout.flush()
+        return
+    with os.fdopen(int(fd), "wb", closefd=False) as f:
+        f.write(json.dumps(o).encode())
+
+def run_once(run):
+    i = json.loads(read_input())
+    if isinstance(i, list):
+        # A batch; see batch_size
+        o = [run_item(run, item) for item in i]
+    else:
+        o = run(i)
+    write_output(o)
+
+def run_persistent(run):
+    for line in sys.stdin:
+        print(json.dumps(run(json.loads(line))), flush=True)
+
+def exit_code(status):
+    if os.WIFSIGNALED(status):
+        return -os.WTERMSIG(status)
+    return os.WEXITSTATUS(status)
+
+def run_zygote(run):
+    ctl = socket.socket(fileno=int(os.environ["ROYALE_CONTROL_FD"]))
+
+    wake_r, wake_w = os.pipe()
+    os.set_blocking(wake_w, False)
+    signal.set_wakeup_fd(wake_w)
+    signal.signal(signal.SIGCHLD, lambda *args: None)
+
+    sel = selectors.DefaultSelector()
+    sel.register(ctl, selectors.EVENT_READ)
+    sel.register(wake_r, selectors.EVENT_READ)
+
+    ctl.send(json.dumps({"ready": True}).encode())
+
+    children = {}
+    while True:
+        for key, _ in sel.select():
+            if key.fileobj is ctl:
+                fds = array.array("i")
+                msg, anc, _, _ = ctl.recvmsg(
+                    4096, socket.CMSG_SPACE(3 * fds.itemsize))
+                if not msg:
+                    return
+                for level, kind, data in anc:
+                    if level == socket.SOL_SOCKET and \
+                            kind == socket.SCM_RIGHTS:
+                        fds.frombytes(
+                            data[:len(data) - len(data) % fds.itemsize])
+                req = json.loads(msg)
+
+                sys.stdout.flush()
+                sys.stderr.flush()
+                pid = os.fork()
+                if pid == 0:
+                    os.setpgid(0, 0)
+                    signal.set_wakeup_fd(-1)
+                    signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+                    ctl.close()
+                    for i, fd in enumerate(fds):
+                        os.dup2(fd, i)
+                    for fd in fds:
+                        os.close(fd)
+                    code = 0
+                    try:
+                        run_once(run)
+                    except BaseException:
+                        import traceback
+                        traceback.print_exc()
+                        code = 1
+                    sys.stderr.flush()
+                    os._exit(code)
+
+                for fd in fds:
+                    os.close(fd)
+                children[pid] = req["id"]
+                ctl.send(json.dumps({"id": req["id"], "pid": pid}).encode())
+            else:
+                os.read(wake_r, 4096)
+                while children:
+                    pid, status = os.waitpid(-1, os.WNOHANG)
+                    if pid == 0:
+                        break
+                    ctl.send(json.dumps({
+                        "id": children.pop(pid),
+                        "status": exit_code(status)}).encode())
+
+def main(run):
+    protocol = os.environ.get("ROYALE_PROTOCOL", "spawn")
+    if protocol == "persistent":
+        run_persistent(run)
+    elif protocol == "zygote":
+        run_zygote(run)
+    else:
+        run_once(run)
@@ -0,0 +1,57 @@
+// In-process version of triangle_executor.py; see royale/plugin.h.
+// Build with "make plugins".
+#include <cmath>
+#include <string>
+#include <nlohmann/json.hpp>
+#include <royale/plugin.h>
+
+using json = nlohmann::json;
+
+static double angle(const double *c, const double *l, const double *r)
+{
+  double result = std::atan2(r[1] - c[1], r[0] - c[0]) -
+                  std::atan2(l[1] - c[1], l[0] - c[0]);
+  if (result > M_PI) {
+    result -= M_PI * 2;
+  }
+  if (result < -M_PI) {
+    result += M_PI * 2;
+  }
+  return result;
+}
+
+extern "C" int royale_run(const char *input, size_t len,
+    royale_output_fn output, void *ctx)
+{
+  try {
+    json i = json::parse(input, input + len);
+    const json &s = i.at("sample");
+    double points[3][2] = {
+      {s.at("x0"), s.at("y0")},
+      {s.at("x1"), s.at("y1")},
+      {s.at("x2"), s.at("y2")},
+    };
+
+    double angles[3] = {
+      angle(points[0], points[1], points[2]),
+      angle(points[1], points[0], points[2]),
+      angle(points[2], points[0], points[1]),
+    };
+
+    bool acute = true;
+    for (double a : angles) {
+      acute = acute && std::abs(a) < M_PI / 2;
+    }
+
+    json o = {
+      {"replicate", nullptr},
+      {"preds", {{"acute", acute}}},
+      {"aux", {{"angles", angles}}},
+    };
+    std::string out = o.dump();
+    output(ctx, out.data(), out.size());
+    return 0;
+  } catch (const std::exception &) {
+    return 1;
+  }
+}
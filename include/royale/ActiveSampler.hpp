@@ -0,0 +1,94 @@
+#ifndef INCL_ROYALE_ACTIVESAMPLER_HPP
+#define INCL_ROYALE_ACTIVESAMPLER_HPP
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Draws samples of an experiment's inputs where its predicates are least
+/// certain, by the last fit of the LogisticRegression analysis, so trials
+/// aren't spent where the outcome is already clear.
+///
+/// Each sample is picked from pool() candidates drawn from the inputs' own
+/// specs, so stays within their bounds: with probability explore(), any of
+/// them, and otherwise in proportion to their uncertainty. Each trial's
+/// TrialInput::weight is the approximate likelihood ratio of its pick, so
+/// weighted probabilities stay unbiased; coefficients fit unweighted, as
+/// picking by input doesn't change each input's chance of an outcome.
+class ActiveSampler
+{
+public:
+  using preds_type = std::vector<std::string>;
+  using coeffs_type = LogisticPredicateOutput::coeffs_type;
+  using fits_type = std::map<std::string, coeffs_type>;
+
+  ROYALE_JSON_FIELDS(ActiveSampler,
+      (preds_type, preds)
+      (size_t, pool, 64)
+      (double, explore, 0.1)
+      (size_t, fit_count, 0)
+      (fits_type, fits)
+    );
+
+private:
+  /// Samples and predicates of the trials added so far, to fit from
+  struct Seen
+  {
+    TrialInput::sample_type sample;
+    TrialOutput::preds_type preds;
+  };
+
+  std::string experiment_name_;
+  std::vector<Seen> seen_;
+  std::mt19937_64 random_;
+
+public:
+  ActiveSampler() = default;
+
+  /// Sampler for the uncertainty of @a preds, picking from @a pool
+  /// candidates per sample. Throws if there are no predicates, or @a pool is
+  /// 0, or @a explore isn't within (0, 1].
+  ActiveSampler(preds_type preds, size_t pool = 64, double explore = 0.1,
+      unsigned int seed = std::random_device()());
+
+  const preds_type &preds() const { return preds_; }
+  size_t pool() const { return pool_; }
+  double explore() const { return explore_; }
+
+  /// Times refit() has succeeded
+  size_t fit_count() const { return fit_count_; }
+
+  /// Coefficients of each predicate from the last fit
+  const fits_type &fits() const { return fits_; }
+  ActiveSampler &fits(fits_type fits)
+  {
+    fits_ = std::move(fits);
+    return *this;
+  }
+
+  /// Uncertainty of the predicates at @a sample: the sum, over those fit,
+  /// of 4p(1-p) for predicted probability p; 1 before any fit
+  double uncertainty(const TrialInput::sample_type &sample) const;
+
+  /// Keep a completed trial's sample and predicates for the next refit().
+  /// Incomplete trials are ignored.
+  void add(const Trial &trial);
+
+  /// Fit the predicates again from the trials added so far, by the
+  /// LogisticRegression analysis. Predicates it couldn't fit, such as those
+  /// never seen, keep their last fit, as do all if the analysis fails.
+  void refit(io::yield_context yield);
+
+  /// @a n new trials of @a exp, with samples picked as above
+  std::vector<Trial> draw(const Experiment &exp, size_t n);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_ACTIVESAMPLER_HPP
@@ -0,0 +1,120 @@
+#ifndef INCL_ROYALE_BLOB_HPP
+#define INCL_ROYALE_BLOB_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <boost/filesystem.hpp>
+#include "royale/util.hpp"
+
+namespace royale {
+
+/// Content-addressed store of text blobs, keyed by SHA-1 digest, so text
+/// repeated across trials, like the same warnings on every trial's stderr,
+/// is kept once. Holds blobs either in memory, as sent alongside trials over
+/// the wire, or as files in a directory, one per digest.
+class BlobStore
+{
+public:
+  using blobs_type = std::map<std::string, std::string>;
+private:
+  boost::filesystem::path dir_;
+  blobs_type blobs_;
+  std::set<std::string> known_;
+
+  static BlobStore *&default_ptr();
+
+public:
+  /// In-memory store
+  BlobStore() = default;
+
+  /// In-memory store, holding @a blobs
+  explicit BlobStore(blobs_type blobs) : blobs_(std::move(blobs)) {}
+
+  /// On-disk store in @a dir, which is created if needed
+  explicit BlobStore(boost::filesystem::path dir);
+
+  /// Hex SHA-1 digest of @a text
+  static std::string digest(const std::string &text);
+
+  /// Store @a text, unless already stored, and return its digest
+  std::string put(const std::string &text);
+
+  /// Text of a stored blob. Throws if not found.
+  std::string get(const std::string &digest) const;
+
+  /// Blobs held in memory
+  const blobs_type &blobs() const { return blobs_; }
+  blobs_type &blobs() { return blobs_; }
+
+  /// Store used to load blobs read without their text, such as from a results
+  /// file, when their text is asked for. May be null.
+  static BlobStore *default_store() { return default_ptr(); }
+  static void default_store(BlobStore *store) { default_ptr() = store; }
+};
+
+/// Text which may be held out of line, in a BlobStore. Serialized as a plain
+/// JSON string, or as {"$blob": digest} once externalized.
+class Blob
+{
+private:
+  mutable std::string text_;
+  mutable bool has_text_ = true;
+  std::string digest_;
+
+public:
+  Blob() = default;
+
+  Blob(std::string text) : text_(std::move(text)) {}
+  Blob(const char *text) : text_(text) {}
+
+  /// Blob known only by its digest, to be loaded from the default store
+  static Blob ref(std::string digest)
+  {
+    Blob ret;
+    ret.has_text_ = false;
+    ret.digest_ = std::move(digest);
+    return ret;
+  }
+
+  /// Digest, if externalized; otherwise empty
+  const std::string &digest() const { return digest_; }
+
+  /// Check if the text is at hand, without loading it
+  bool loaded() const { return has_text_; }
+
+  /// The text, loaded from BlobStore::default_store() on first use if this
+  /// blob was read as a digest only
+  const std::string &text() const;
+
+  operator const std::string &() const { return text(); }
+
+  /// Put the text in @a store, and serialize only its digest from now on, if
+  /// it's at least @a min_size bytes
+  void externalize(BlobStore &store, size_t min_size = 0);
+
+  /// Load the text from @a store, if not loaded, and serialize it inline
+  void internalize(const BlobStore &store);
+
+  friend void to_json(json &j, const Blob &b)
+  {
+    if (b.digest_ != "") {
+      j = {{"$blob", b.digest_}};
+    } else {
+      j = b.text_;
+    }
+  }
+
+  friend void from_json(const json &j, Blob &b)
+  {
+    if (j.is_object()) {
+      b = ref(j.at("$blob").get<std::string>());
+    } else {
+      b = Blob(j.get<std::string>());
+    }
+  }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_BLOB_HPP
@@ -0,0 +1,111 @@
+#ifndef INCL_ROYALE_CAPTURE_HPP
+#define INCL_ROYALE_CAPTURE_HPP
+
+#include <array>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include "royale/util.hpp"
+
+namespace royale {
+
+namespace io = boost::asio;
+
+/// Limits on how much of an executor's stdout or stderr is kept
+struct CaptureConfig
+{
+  /// Bytes kept in memory per stream; half from the start of the stream, half
+  /// from the end. If 0, streams are kept whole.
+  size_t limit = 1 << 20;
+
+  /// If not empty, streams over the limit are written whole to a file here
+  std::string spill_dir;
+};
+
+/// Collects an output stream within a CaptureConfig's limit, so memory use
+/// stays flat however much an executor writes. Once the stream outgrows the
+/// limit, the middle is dropped, and the whole stream spills to a file, if
+/// enabled.
+class StreamCapture
+{
+private:
+  CaptureConfig config_;
+  std::string label_;
+  std::string head_;
+  std::vector<char> tail_;
+  size_t tail_pos_ = 0;
+  uint64_t total_ = 0;
+  std::unique_ptr<std::ofstream> spill_;
+  std::string spill_path_;
+  std::array<char, 4096> buf_;
+  std::function<void(const char *, size_t)> on_data_;
+
+  size_t head_max() const { return config_.limit - config_.limit / 2; }
+  size_t tail_max() const { return config_.limit / 2; }
+
+  void start_spill();
+
+  template<typename Stream, typename Handler>
+  friend void async_capture(std::shared_ptr<Stream> stream,
+      std::shared_ptr<StreamCapture> cap, Handler handler);
+
+public:
+  /// @a label names the stream, such as "stdout", in spill file names
+  StreamCapture(CaptureConfig config, std::string label)
+    : config_(std::move(config)), label_(std::move(label)) {}
+
+  /// Also pass all data to @a f as it is appended, such as to an incremental
+  /// parser which needs the whole stream
+  void on_data(std::function<void(const char *, size_t)> f)
+  {
+    on_data_ = std::move(f);
+  }
+
+  void append(const char *data, size_t n);
+
+  /// Bytes written to the stream in total
+  uint64_t total() const { return total_; }
+
+  /// Check if bytes were dropped from the middle of the stream
+  bool truncated() const
+  {
+    return config_.limit > 0 && total_ > config_.limit;
+  }
+
+  /// Path of the file holding the whole stream, or empty if not spilled
+  const std::string &spill_path() const { return spill_path_; }
+
+  /// The kept text. If truncated, a marker line stands in for the middle.
+  std::string str() const;
+
+  /// Return str() and start over, as if nothing had been written
+  std::string take();
+};
+
+/// Read from @a stream into @a cap until EOF or error, then call @a handler.
+/// Pending reads hold on to both, so they may outlive their owners.
+template<typename Stream, typename Handler>
+void async_capture(std::shared_ptr<Stream> stream,
+    std::shared_ptr<StreamCapture> cap, Handler handler)
+{
+  auto &s = *stream;
+  auto &buf = cap->buf_;
+  s.async_read_some(io::buffer(buf),
+    [stream = std::move(stream), cap = std::move(cap),
+     handler = std::move(handler)]
+    (const boost::system::error_code &ec, size_t n) mutable {
+      cap->append(cap->buf_.data(), n);
+      if (ec) {
+        handler();
+        return;
+      }
+      async_capture(std::move(stream), std::move(cap), std::move(handler));
+    });
+}
+
+} // namespace royale
+
+#endif // INCL_ROYALE_CAPTURE_HPP
@@ -0,0 +1,114 @@
+#ifndef INCL_ROYALE_ENUMERATION_HPP
+#define INCL_ROYALE_ENUMERATION_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/InputSpec.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Every possible sample of an InputSpec whose values each have finitely
+/// many possibilities, with its probability: the Cartesian product of the
+/// values' supports. Points are numbered 0 to size() - 1, so ranges or
+/// strides of them can be run separately.
+class InputEnumeration
+{
+private:
+  using values_type = std::vector<std::pair<Value, double>>;
+
+  std::vector<std::pair<std::string, values_type>> inputs_;
+  size_t size_ = 1;
+
+public:
+  /// Enumeration of @a spec, or null if it has infinitely many samples, or
+  /// more than @a max_size
+  static std::unique_ptr<InputEnumeration> of(const InputSpec &spec,
+      size_t max_size);
+
+  /// Number of distinct samples
+  size_t size() const { return size_; }
+
+  /// Sample number @a i, with its probability
+  std::pair<InputSpec::sample_type, double> at(size_t i) const;
+};
+
+/// Exact probability of a predicate over an enumeration's samples
+class ExactPredicateOutput
+{
+  ROYALE_JSON_FIELDS(ExactPredicateOutput,
+      (double, sat_mass, 0)
+      (double, mass, 0)
+      (double, prob, 0)
+    );
+
+public:
+  /// Total probability of samples run where the predicate held
+  double sat_mass() const { return sat_mass_; }
+
+  /// Total probability of samples run which gave the predicate
+  double mass() const { return mass_; }
+
+  /// sat_mass() over mass(): exactly the predicate's probability, once
+  /// mass() is 1
+  double prob() const { return prob_; }
+
+  void add(bool sat, double weight)
+  {
+    mass_ += weight;
+    sat_mass_ += sat ? weight : 0;
+    prob_ = mass_ > 0 ? sat_mass_ / mass_ : 0;
+  }
+};
+
+/// Results of running one experiment's enumeration, or one shard of it.
+/// Shards' results combine by summing their predicates' sat_mass and mass.
+class EnumerationSummary
+{
+public:
+  using preds_type = std::map<std::string, ExactPredicateOutput>;
+
+  ROYALE_JSON_FIELDS(EnumerationSummary,
+      (std::string, experiment)
+      (size_t, size, 0)
+      (size_t, shard, 0)
+      (size_t, shards, 1)
+      (size_t, count, 0)
+      (size_t, error_count, 0)
+      (preds_type, preds)
+    );
+
+public:
+  EnumerationSummary() = default;
+
+  EnumerationSummary(std::string experiment, size_t size, size_t shard,
+      size_t shards)
+    : experiment_(std::move(experiment)), size_(size), shard_(shard),
+      shards_(shards) {}
+
+  const std::string &experiment() const { return experiment_; }
+
+  /// Samples in the whole enumeration
+  size_t size() const { return size_; }
+
+  size_t shard() const { return shard_; }
+  size_t shards() const { return shards_; }
+
+  /// Trials seen, including errors
+  size_t count() const { return count_; }
+  size_t error_count() const { return error_count_; }
+
+  const preds_type &preds() const { return preds_; }
+
+  /// Count a trial of the experiment, by the probability of its sample: its
+  /// TrialInput::weight over size()
+  void add(const Trial &trial);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_ENUMERATION_HPP
@@ -3,6 +3,7 @@
 
 #include <utility>
 #include "royale/util.hpp"
+#include "royale/Blob.hpp"
 
 namespace royale {
 
@@ -10,7 +11,10 @@ class ErrorKind : public xtd::JsonObject
 {
 public:
   ROYALE_JSON_ENUM(ErrorKind, Exception, ErrorCode, ExitStatus, BadOutput,
-      UnknownExperiment);
+      UnknownExperiment, Timeout, MemoryLimit, ExecutorError);
+
+  /// Call @a f on each Blob held, such as executor output
+  virtual void for_each_blob(const std::function<void(Blob &)> &) {}
 };
 
 class ErrorKind::Exception : public xtd::EnableJsonObject<Exception, ErrorKind>
@@ -46,8 +50,8 @@ class ErrorKind::ErrorCode : public xtd::EnableJsonObject<ErrorCode, ErrorKind>
       (int, value)
       (std::string, message)
       (std::string, category)
-      (std::string, stdout)
-      (std::string, stderr)
+      (Blob, stdout)
+      (Blob, stderr)
     );
 public:
   ErrorCode() = default;
@@ -56,33 +60,112 @@ public:
     : value_(code.value()), message_(code.message()),
       category_(code.category().name()),
       stdout_(stdout), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stdout_);
+    f(stderr_);
+  }
 };
 
 class ErrorKind::ExitStatus : public xtd::EnableJsonObject<ExitStatus, ErrorKind>
 {
   ROYALE_JSON_FIELDS(ExitStatus,
       (int, code)
-      (std::string, stdout)
-      (std::string, stderr)
+      (Blob, stdout)
+      (Blob, stderr)
     );
 public:
   ExitStatus() = default;
 
   ExitStatus(int code, std::string stdout, std::string stderr)
     : code_(code), stdout_(stdout), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stdout_);
+    f(stderr_);
+  }
 };
 
 class ErrorKind::BadOutput : public xtd::EnableJsonObject<BadOutput, ErrorKind>
 {
   ROYALE_JSON_FIELDS(BadOutput,
-      (std::string, stdout)
-      (std::string, stderr)
+      (Blob, stdout)
+      (Blob, stderr)
     );
 public:
   BadOutput() = default;
 
   BadOutput(std::string stdout, std::string stderr)
     : stdout_(stdout), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stdout_);
+    f(stderr_);
+  }
+};
+
+class ErrorKind::Timeout : public xtd::EnableJsonObject<Timeout, ErrorKind>
+{
+  ROYALE_JSON_FIELDS(Timeout,
+      (double, elapsed)
+      (Blob, stdout)
+      (Blob, stderr)
+    );
+public:
+  Timeout() = default;
+
+  Timeout(double elapsed, std::string stdout, std::string stderr)
+    : elapsed_(elapsed), stdout_(stdout), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stdout_);
+    f(stderr_);
+  }
+};
+
+class ErrorKind::MemoryLimit : public xtd::EnableJsonObject<MemoryLimit, ErrorKind>
+{
+  ROYALE_JSON_FIELDS(MemoryLimit,
+      (uint64_t, memory_max)
+      (Blob, stdout)
+      (Blob, stderr)
+    );
+public:
+  MemoryLimit() = default;
+
+  MemoryLimit(uint64_t memory_max, std::string stdout, std::string stderr)
+    : memory_max_(memory_max), stdout_(stdout), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stdout_);
+    f(stderr_);
+  }
+};
+
+/// An error the executor reported for one trial of a batch, as
+/// {"error": ...} in place of its output
+class ErrorKind::ExecutorError
+  : public xtd::EnableJsonObject<ExecutorError, ErrorKind>
+{
+  ROYALE_JSON_FIELDS(ExecutorError,
+      (json, error)
+      (Blob, stderr)
+    );
+public:
+  ExecutorError() = default;
+
+  ExecutorError(json error, std::string stderr)
+    : error_(std::move(error)), stderr_(stderr) {}
+
+  void for_each_blob(const std::function<void(Blob &)> &f) override
+  {
+    f(stderr_);
+  }
 };
 
 } // namespace royale
@@ -0,0 +1,104 @@
+#ifndef INCL_ROYALE_EXECUTORPOOL_HPP
+#define INCL_ROYALE_EXECUTORPOOL_HPP
+
+#include <list>
+#include <utility>
+#include <boost/asio/spawn.hpp>
+#include <boost/process.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/LaunchPlan.hpp"
+#include "royale/Capture.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+namespace bp = boost::process;
+
+/// A long-lived executor process, speaking the "persistent" protocol: one
+/// TrialInput JSON per line on its stdin, one TrialOutput JSON per line on
+/// its stdout.
+class PersistentExecutor
+{
+private:
+  bp::async_pipe in_;
+  bp::async_pipe out_;
+  std::shared_ptr<bp::async_pipe> err_;
+  bp::group group_;
+  bp::child child_;
+  io::steady_timer timer_;
+  bool timed_out_ = false;
+  io::streambuf out_buf_;
+  std::shared_ptr<StreamCapture> stderr_;
+  size_t trials_ = 0;
+
+public:
+  /// Output lines longer than @a capture's limit are treated as the executor
+  /// failing
+  PersistentExecutor(io::io_context &ioc, const Experiment &exp,
+      const LaunchPlan &plan, const CaptureConfig &capture);
+
+  PersistentExecutor(const PersistentExecutor &) = delete;
+  PersistentExecutor &operator=(const PersistentExecutor &) = delete;
+
+  ~PersistentExecutor();
+
+  /// Send one trial, and wait for its output line. Returns false, leaving
+  /// the trial status untouched, if the executor died before answering. If
+  /// @a timeout is positive and passes first, the executor's process group is
+  /// killed, and timed_out() becomes true.
+  bool run(Trial &trial, std::string &sout, double timeout,
+      io::yield_context yield);
+
+  bool timed_out() const { return timed_out_; }
+
+  /// Stderr output received since the last call. If it spilled to a file,
+  /// the file is recorded in @a trial.
+  std::string take_stderr(Trial &trial);
+
+  /// Close stdin, asking the executor to exit once idle
+  void retire();
+
+  /// Wait up to 100ms for the executor to exit (killing it if it doesn't)
+  /// and return its exit code. Yields, rather than blocking other trials.
+  int reap(io::yield_context yield);
+
+  /// Check if a retired executor has exited. Never blocks.
+  bool exited();
+
+  size_t trials() const { return trials_; }
+  int pid() { return child_.id(); }
+};
+
+/// Pool of PersistentExecutors for one experiment. Executors are started on
+/// demand, so the pool grows to the number of concurrent trials, restarted
+/// when they crash, and retired once they have run Experiment::recycle trials
+class ExecutorPool
+{
+public:
+  using executor_ptr = std::unique_ptr<PersistentExecutor>;
+private:
+  io::io_context *ioc_;
+  const Experiment *exp_;
+  LaunchPlan plan_;
+  CaptureConfig capture_;
+  std::list<executor_ptr> idle_;
+  std::list<executor_ptr> retiring_;
+
+  executor_ptr acquire();
+  void release(executor_ptr e);
+
+public:
+  ExecutorPool(io::io_context &ioc, const Experiment &exp,
+      const LaunchPlan &plan, CaptureConfig capture)
+    : ioc_(&ioc), exp_(&exp),
+      plan_(plan.with_env({{"ROYALE_PROTOCOL", "persistent"}})),
+      capture_(std::move(capture)) {}
+
+  /// Run the trial on an idle executor, starting one if needed
+  Trial run(Trial trial, io::yield_context yield);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_EXECUTORPOOL_HPP
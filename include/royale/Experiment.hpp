@@ -27,6 +27,18 @@ private:
       (std::vector<std::string>, cmd)
       (env_type, env)
       (InputSpec, input)
+      (std::string, protocol, "spawn")
+      (std::string, transport, "pipe")
+      (std::string, plugin)
+      (bool, isolate, false)
+      (size_t, batch_size, 0)
+      (size_t, recycle, 0)
+      (std::string, cpuset)
+      (size_t, cpus, 0)
+      (uint64_t, memory_max, 0)
+      (size_t, cpu_weight, 0)
+      (bool, deterministic, false)
+      (input_type, proposal)
     );
 
 public:
@@ -46,6 +58,11 @@ public:
 
   const std::string &cd() const { return cd_; }
 
+  /// Seconds a trial may run before its executor is killed, or 0 if unlimited
+  Experiment &timeout(double t) { timeout_ = t; return *this; }
+
+  double timeout() const { return timeout_; }
+
   template<typename... Args>
   auto cmd(Args&&... args) ->
     xtd::enable_if<(sizeof...(Args) > 0), Experiment &>
@@ -70,6 +87,90 @@ public:
 
   const std::vector<std::string> &cmd() const { return cmd_; }
 
+  /// How trials are passed to the executor: "spawn" starts a new process per
+  /// trial; "persistent" keeps executors running, one trial per line;
+  /// "zygote" starts the executor once, and has it fork a child per trial
+  Experiment &protocol(std::string p)
+  {
+    protocol_ = std::move(p);
+    return *this;
+  }
+
+  const std::string &protocol() const { return protocol_; }
+
+  /// How the spawn protocol passes trial input and output: "pipe" uses the
+  /// executor's stdin and stdout; "memfd" uses in-memory files, whose fds
+  /// are in ROYALE_INPUT_FD and ROYALE_OUTPUT_FD, for large samples and aux
+  /// values
+  Experiment &transport(std::string t)
+  {
+    transport_ = std::move(t);
+    return *this;
+  }
+
+  const std::string &transport() const { return transport_; }
+
+  /// Shared library implementing royale/plugin.h, called in-process for each
+  /// trial instead of running cmd. If empty, cmd is run.
+  Experiment &plugin(std::string p) { plugin_ = std::move(p); return *this; }
+
+  const std::string &plugin() const { return plugin_; }
+
+  /// Call the plugin in helper processes, which are restarted if it crashes,
+  /// rather than in the runner itself
+  Experiment &isolate(bool i) { isolate_ = i; return *this; }
+
+  bool isolate() const { return isolate_; }
+
+  /// For the spawn protocol, pass this many trials to each executor, as a
+  /// JSON array of TrialInput, expecting an array of outputs back. If 0 or
+  /// 1, each executor gets one trial.
+  Experiment &batch_size(size_t k) { batch_size_ = k; return *this; }
+
+  size_t batch_size() const { return batch_size_; }
+
+  /// For persistent executors, restart each after this many trials. If 0,
+  /// executors are only restarted if they exit.
+  Experiment &recycle(size_t n) { recycle_ = n; return *this; }
+
+  size_t recycle() const { return recycle_; }
+
+  /// CPUs executors may run on, as a Linux CPU list like "0-3,8". If empty,
+  /// any of the runner's CPUs.
+  Experiment &cpuset(std::string c) { cpuset_ = std::move(c); return *this; }
+
+  const std::string &cpuset() const { return cpuset_; }
+
+  /// Pin each trial to this many CPUs of its own, from cpuset, preferring a
+  /// single NUMA node. If 0, trials aren't pinned beyond cpuset.
+  Experiment &cpus(size_t n) { cpus_ = n; return *this; }
+
+  size_t cpus() const { return cpus_; }
+
+  /// Bytes of memory a trial may use before it is killed, or 0 if unlimited.
+  /// Needs the runner's --cgroup option.
+  Experiment &memory_max(uint64_t m) { memory_max_ = m; return *this; }
+
+  uint64_t memory_max() const { return memory_max_; }
+
+  /// Relative cgroup v2 CPU weight for trials, 1 to 10000, or 0 for the
+  /// default. Needs the runner's --cgroup option.
+  Experiment &cpu_weight(size_t w) { cpu_weight_ = w; return *this; }
+
+  size_t cpu_weight() const { return cpu_weight_; }
+
+  /// Trials with the same sample and replicate always give the same output,
+  /// so the runner's memo cache, if any, may answer them without running
+  /// anything. Such experiments must have a version, and it must change
+  /// whenever the executor's behavior does.
+  Experiment &deterministic(bool d) { deterministic_ = d; return *this; }
+
+  bool deterministic() const { return deterministic_; }
+
+  Experiment &version(std::string v) { version_ = std::move(v); return *this; }
+
+  const std::string &version() const { return version_; }
+
   Experiment &env(env_type e) { env_ = std::move(e); return *this; }
 
   Experiment &env(
@@ -90,6 +191,14 @@ public:
 
   const InputSpec &inputs() const { return input_; }
 
+  /// For importance sampling, specs to draw some inputs from instead, such
+  /// as ones making rare failures common. Each trial's TrialInput::weight is
+  /// then its likelihood ratio, which weights its predicates. Each proposal
+  /// must be able to give every value its input can.
+  Experiment &proposal(input_type p) { proposal_ = std::move(p); return *this; }
+
+  const input_type &proposal() const { return proposal_; }
+
   xtd::map_inserter<input_type> extend_inputs()
   {
     return input_.extend_inputs();
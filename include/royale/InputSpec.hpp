@@ -47,6 +47,28 @@ public:
     }
     return ret;
   }
+
+  /// Sample for importance sampling: inputs in @a proposal are drawn from
+  /// there instead. Returns the sample and its likelihood ratio, the product
+  /// over those inputs of their density here over their density in
+  /// @a proposal.
+  std::pair<sample_type, double> sample(const input_type &proposal) const
+  {
+    std::pair<sample_type, double> ret;
+    ret.second = 1;
+    for (const auto &i : input_) {
+      auto p = proposal.find(i.first);
+      if (p == proposal.end()) {
+        ret.first.emplace(i.first, i.second->sample());
+        continue;
+      }
+      Value v = p->second->sample();
+      double q = p->second->density(v);
+      ret.second *= q > 0 ? i.second->density(v) / q : 0;
+      ret.first.emplace(i.first, std::move(v));
+    }
+    return ret;
+  }
 };
 
 } // namespace royale
@@ -0,0 +1,84 @@
+#ifndef INCL_ROYALE_INTERVALESTIMATE_HPP
+#define INCL_ROYALE_INTERVALESTIMATE_HPP
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Wilson score interval, at @a confidence, of a probability seen to be
+/// satisfied @a sat times in @a n trials; [0, 1] if @a n is 0
+std::pair<double, double> wilson_interval(size_t sat, size_t n,
+    double confidence);
+
+/// Clopper-Pearson ("exact") interval, at @a confidence, of a probability
+/// seen to be satisfied @a sat times in @a n trials; [0, 1] if @a n is 0.
+/// Wider than wilson_interval(), but never covers less than @a confidence.
+std::pair<double, double> clopper_pearson_interval(size_t sat, size_t n,
+    double confidence);
+
+/// Normal-approximation interval, at @a confidence, of the mean of @a n
+/// weights of which the nonzero ones sum to @a sum and their squares to
+/// @a sum_sq, as in importance sampling; [0, 1] if @a n is less than 2
+std::pair<double, double> weighted_interval(double sum, double sum_sq,
+    size_t n, double confidence);
+
+/// Trials enough, by the Okamoto (Chernoff-Hoeffding) bound, for the
+/// estimated probability to be within @a half_width of the true one with
+/// probability @a confidence, whatever it is
+size_t okamoto_trials(double half_width, double confidence);
+
+/// Estimates of predicates' probabilities, with confidence intervals updated
+/// as trials complete, so a run can stop once every interval is narrow
+/// enough.
+///
+/// The number of trials planned() up front comes from okamoto_trials(); it's
+/// enough for any probability, but intervals of probabilities far from 0.5
+/// are usually narrow enough sooner. It doesn't hold for weighted trials.
+class IntervalEstimate
+{
+public:
+  using preds_type = std::map<std::string, PredicateOutput>;
+
+  ROYALE_JSON_FIELDS(IntervalEstimate,
+      (std::string, method, "wilson")
+      (double, confidence, 0.95)
+      (double, half_width, 0.01)
+      (size_t, planned, 0)
+      (preds_type, preds)
+    );
+
+public:
+  IntervalEstimate() = default;
+
+  /// Estimate of each of @a preds to within @a half_width at @a confidence,
+  /// by @a method "wilson" or "clopper-pearson". Throws if any are invalid.
+  IntervalEstimate(const std::vector<std::string> &preds, double half_width,
+      double confidence, std::string method = "wilson");
+
+  const std::string &method() const { return method_; }
+  double confidence() const { return confidence_; }
+  double half_width() const { return half_width_; }
+
+  /// Trials planned by the Okamoto bound
+  size_t planned() const { return planned_; }
+
+  /// Estimates so far, with their intervals
+  const preds_type &preds() const { return preds_; }
+
+  /// True once every predicate's interval is within half_width()
+  bool done() const;
+
+  /// Update from a completed trial, by its TrialInput::weight. Trials
+  /// without a predicate, such as failed ones, are counted as its errors,
+  /// and don't narrow its interval. Returns done().
+  bool add(const Trial &trial);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_INTERVALESTIMATE_HPP
@@ -0,0 +1,52 @@
+#ifndef INCL_ROYALE_JOURNAL_HPP
+#define INCL_ROYALE_JOURNAL_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Append-only file of completed trials, one JSON line each, so a long run
+/// killed partway can be resumed from it. Each trial's TrialInput::seq
+/// records its place in its experiment's input sequence.
+///
+/// Writes are synced to disk in groups: once @a group trials are unsynced,
+/// or a second has passed since the last sync, and on sync() and
+/// destruction. A crash loses at most the unsynced group.
+class Journal
+{
+private:
+  int fd_ = -1;
+  std::string path_;
+  size_t group_;
+  size_t unsynced_ = 0;
+  std::chrono::steady_clock::time_point synced_at_;
+
+public:
+  /// Open @a path for appending, creating it if needed
+  explicit Journal(std::string path, size_t group = 256);
+
+  Journal(const Journal &) = delete;
+  Journal &operator=(const Journal &) = delete;
+
+  ~Journal();
+
+  const std::string &path() const { return path_; }
+
+  void append(const Trial &trial);
+
+  /// Flush appended trials to disk now
+  void sync();
+
+  /// Trials recorded in the journal at @a path. A partly written last line,
+  /// as left by a crash, is dropped, and cut from the file so later appends
+  /// start on a line of their own. Throws if any other line is bad.
+  static std::vector<Trial> load(const std::string &path);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_JOURNAL_HPP
@@ -0,0 +1,72 @@
+#ifndef INCL_ROYALE_LAUNCHPLAN_HPP
+#define INCL_ROYALE_LAUNCHPLAN_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/process/extend.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+
+namespace royale {
+
+/// An experiment's executor command, resolved once when the experiment is
+/// added, so starting a trial doesn't need to search the path or rebuild the
+/// environment. Holds the absolute executable path, its arguments, the start
+/// directory, and a prebuilt environment block: the runner's environment,
+/// overridden by Experiment::env.
+class LaunchPlan
+{
+public:
+  using env_type = std::map<std::string, std::string>;
+private:
+  boost::filesystem::path exe_;
+  std::vector<std::string> args_;
+  boost::filesystem::path start_dir_;
+  env_type vars_;
+  std::vector<std::string> env_;
+  std::vector<char *> envp_;
+
+  void build_envp();
+
+public:
+  LaunchPlan() = default;
+  explicit LaunchPlan(const Experiment &exp);
+
+  LaunchPlan(const LaunchPlan &) = delete;
+  LaunchPlan &operator=(const LaunchPlan &) = delete;
+
+  LaunchPlan(LaunchPlan &&) = default;
+  LaunchPlan &operator=(LaunchPlan &&) = default;
+
+  /// Copy of this plan, with additional environment variables set
+  LaunchPlan with_env(const env_type &extra) const;
+
+  /// Absolute path of the executable, or empty if it wasn't found
+  const boost::filesystem::path &exe() const { return exe_; }
+
+  /// Arguments, not including the executable itself
+  const std::vector<std::string> &args() const { return args_; }
+
+  const boost::filesystem::path &start_dir() const { return start_dir_; }
+
+  const env_type &vars() const { return vars_; }
+
+  /// Null-terminated "KEY=value" array, as passed to execve
+  char *const *envp() const { return envp_.data(); }
+
+  /// Initializer for bp::child, making it use the prebuilt environment block
+  auto env_init() const
+  {
+    char *const *envp = envp_.data();
+    return boost::process::extend::on_setup(
+      [envp](auto &exec) {
+        exec.env = const_cast<char **>(envp);
+      });
+  }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_LAUNCHPLAN_HPP
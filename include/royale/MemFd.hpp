@@ -0,0 +1,79 @@
+#ifndef INCL_ROYALE_MEMFD_HPP
+#define INCL_ROYALE_MEMFD_HPP
+
+#include <string>
+#include "royale/util.hpp"
+
+namespace royale {
+
+/// Read-only mapping of a file, unmapped on destruction
+class MappedFile
+{
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+
+public:
+  MappedFile() = default;
+
+  /// Map all of @a fd, as it is now
+  explicit MappedFile(int fd);
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&o) noexcept : data_(o.data_), size_(o.size_)
+  {
+    o.data_ = nullptr;
+    o.size_ = 0;
+  }
+
+  MappedFile &operator=(MappedFile &&o) noexcept;
+
+  ~MappedFile();
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+};
+
+/// Anonymous in-memory file, from memfd_create(2), for passing trial input
+/// and output to executors without copying it through a pipe. The fd is
+/// close-on-exec; call inherit() in the child to pass it on.
+class MemFd
+{
+private:
+  int fd_ = -1;
+
+public:
+  /// Create an empty memfd; @a name is only for debugging, as in
+  /// /proc/PID/fd
+  explicit MemFd(const char *name);
+
+  MemFd(const MemFd &) = delete;
+  MemFd &operator=(const MemFd &) = delete;
+
+  MemFd(MemFd &&o) noexcept : fd_(o.fd_) { o.fd_ = -1; }
+  MemFd &operator=(MemFd &&o) noexcept;
+
+  ~MemFd();
+
+  int fd() const { return fd_; }
+
+  /// Write all of @a data at the current offset
+  MemFd &write(const std::string &data);
+
+  /// Forbid any further change to the contents, so a reader can trust them,
+  /// and rewind, so a reader sharing the fd starts at the beginning
+  MemFd &seal();
+
+  /// Map the current contents
+  MappedFile map() const { return MappedFile(fd_); }
+
+  /// Clear close-on-exec, so the fd survives exec. Async-signal-safe, for use
+  /// between fork and exec.
+  void inherit() const;
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_MEMFD_HPP
@@ -0,0 +1,93 @@
+#ifndef INCL_ROYALE_MEMOCACHE_HPP
+#define INCL_ROYALE_MEMOCACHE_HPP
+
+#include <list>
+#include <map>
+#include <string>
+#include <boost/filesystem.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Counts of memo cache use, for --stats
+class MemoStats
+{
+  ROYALE_JSON_FIELDS(MemoStats,
+      (size_t, lookups, 0)
+      (size_t, hits, 0)
+      (double, hit_rate, 0)
+      (size_t, evictions, 0)
+    );
+
+public:
+  size_t lookups() const { return lookups_; }
+  size_t hits() const { return hits_; }
+
+  /// hits() over lookups(), or 0 before any lookups
+  double hit_rate() const { return hit_rate_; }
+
+  /// Entries removed to keep within the cache's size bound
+  size_t evictions() const { return evictions_; }
+
+  void add_lookup(bool hit)
+  {
+    ++lookups_;
+    hits_ += hit;
+    hit_rate_ = hits_ / (double)lookups_;
+  }
+
+  void add_eviction() { ++evictions_; }
+};
+
+/// On-disk cache of completed trials' statuses, for deterministic
+/// experiments, so identical trials are only run once. Entries are files in
+/// a directory, named by key(), and the least recently used are removed once
+/// their total size passes a bound. Entries already in the directory, as
+/// left by earlier runs, are used too, least recently modified first to go.
+class MemoCache
+{
+private:
+  using lru_type = std::list<std::string>;
+
+  struct Entry
+  {
+    lru_type::iterator pos;
+    uint64_t size;
+  };
+
+  boost::filesystem::path dir_;
+  uint64_t max_bytes_;
+  uint64_t bytes_ = 0;
+  lru_type lru_;
+  std::map<std::string, Entry> entries_;
+  MemoStats stats_;
+
+  void evict();
+
+public:
+  /// Cache in @a dir, created if needed, of at most @a max_bytes
+  MemoCache(boost::filesystem::path dir, uint64_t max_bytes);
+
+  /// Key of a trial of @a exp with @a input: a digest of the experiment's
+  /// name and version, and the input's sample and replicate
+  static std::string key(const Experiment &exp, const TrialInput &input);
+
+  /// Set @a status from the entry for @a key, if any. Returns whether found.
+  bool get(const std::string &key, TrialStatus::Enum &status);
+
+  /// Store @a status under @a key
+  void put(const std::string &key, const TrialStatus::Enum &status);
+
+  /// Total size of entries, in bytes
+  uint64_t bytes() const { return bytes_; }
+
+  size_t size() const { return entries_.size(); }
+
+  const MemoStats &stats() const { return stats_; }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_MEMOCACHE_HPP
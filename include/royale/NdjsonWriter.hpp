@@ -0,0 +1,52 @@
+#ifndef INCL_ROYALE_NDJSONWRITER_HPP
+#define INCL_ROYALE_NDJSONWRITER_HPP
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <boost/asio.hpp>
+#include "royale/util.hpp"
+
+namespace royale {
+
+namespace io = boost::asio;
+
+/// Writes JSON values one per line (NDJSON) as they're produced, such as
+/// trials as they complete. Lines are buffered, and flushed once the buffer
+/// fills, or shortly after the first line written since the last flush, so
+/// readers see results live without a write per line.
+class NdjsonWriter
+{
+private:
+  std::ostream &out_;
+  std::string buf_;
+  size_t max_;
+  std::chrono::milliseconds delay_;
+  io::steady_timer timer_;
+  bool armed_ = false;
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+
+public:
+  /// Write to @a out, flushing once @a buffer_size bytes are buffered, or
+  /// @a delay after an unflushed line is written
+  NdjsonWriter(io::io_context &ioc, std::ostream &out,
+      size_t buffer_size = 1 << 16,
+      std::chrono::milliseconds delay = std::chrono::milliseconds(100));
+
+  NdjsonWriter(const NdjsonWriter &) = delete;
+  NdjsonWriter &operator=(const NdjsonWriter &) = delete;
+
+  /// Flushes any buffered lines
+  ~NdjsonWriter();
+
+  /// Buffer @a j as one line
+  void write(const json &j);
+
+  /// Write out buffered lines now
+  void flush();
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_NDJSONWRITER_HPP
@@ -0,0 +1,70 @@
+#ifndef INCL_ROYALE_PLUGINPOOL_HPP
+#define INCL_ROYALE_PLUGINPOOL_HPP
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <boost/asio.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/plugin.h"
+
+namespace royale {
+
+namespace io = boost::asio;
+
+/// A plugin library, loaded with dlopen, whose royale_run is called directly
+/// for each trial instead of starting an executor. See royale/plugin.h.
+class Plugin
+{
+private:
+  std::string path_;
+  royale_run_fn run_ = nullptr;
+
+public:
+  /// Load the library at @a path. Throws if it can't be loaded, or has no
+  /// royale_run.
+  explicit Plugin(std::string path);
+
+  Plugin(const Plugin &) = delete;
+  Plugin &operator=(const Plugin &) = delete;
+
+  /// Path of the plugin in @a exp: relative to its cd if it contains a '/';
+  /// otherwise searched for by dlopen, as in LD_LIBRARY_PATH
+  static std::string resolve(const Experiment &exp);
+
+  const std::string &path() const { return path_; }
+
+  /// Run one trial, given its TrialInput JSON, and return the plugin's
+  /// result code and TrialOutput JSON
+  std::pair<int, std::string> run(const std::string &input) const;
+
+  /// Serve the "persistent" executor protocol on stdin and stdout with the
+  /// plugin at @a path, so crashes only take down this process. Returns an
+  /// exit code.
+  static int host(const std::string &path);
+};
+
+/// Runs an experiment's trials with its Plugin, on a pool of threads
+class PluginPool
+{
+public:
+  /// Called on the runner's io_context with the plugin's result code, its
+  /// output, and the seconds it took
+  using handler_type = std::function<void(int, std::string, double)>;
+private:
+  io::io_context *ioc_;
+  Plugin plugin_;
+  io::thread_pool threads_;
+
+public:
+  PluginPool(io::io_context &ioc, const Experiment &exp, size_t threads);
+
+  ~PluginPool();
+
+  void run(std::string input, handler_type handler);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_PLUGINPOOL_HPP
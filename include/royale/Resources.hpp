@@ -0,0 +1,114 @@
+#ifndef INCL_ROYALE_RESOURCES_HPP
+#define INCL_ROYALE_RESOURCES_HPP
+
+#include <set>
+#include <sched.h>
+#include <boost/filesystem.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+
+namespace royale {
+
+/// Set of CPU numbers
+using CpuSet = std::set<int>;
+
+/// Parse a Linux CPU list, like "0-3,8"
+CpuSet parse_cpu_list(const std::string &list);
+
+/// Format a CpuSet as a Linux CPU list
+std::string format_cpu_list(const CpuSet &cpus);
+
+/// Hands out CPUs to trials, grouped by NUMA node, so concurrent trials don't
+/// share cores, and each trial's CPUs share a memory controller where possible
+class CpuAllocator
+{
+private:
+  std::vector<CpuSet> nodes_;
+  std::vector<CpuSet> free_;
+
+public:
+  /// Discover NUMA nodes from sysfs, limited to the CPUs this process may use
+  CpuAllocator();
+
+  /// Use the given nodes, each a set of CPUs
+  explicit CpuAllocator(std::vector<CpuSet> nodes);
+
+  const std::vector<CpuSet> &nodes() const { return nodes_; }
+
+  /// Take @a n free CPUs, from @a allowed if not empty. The CPUs come from a
+  /// single node if any has enough free; the fullest such node is used, to
+  /// keep other nodes open for later requests. Otherwise they are spread over
+  /// nodes, emptiest first. Returns an empty set if too few are free.
+  CpuSet acquire(size_t n, const CpuSet &allowed = {});
+
+  void release(const CpuSet &cpus);
+};
+
+/// A cgroup v2 directory created for one trial. Removed when destroyed.
+class CgroupLeaf
+{
+private:
+  boost::filesystem::path path_;
+  std::string procs_;
+
+public:
+  /// Create @a name under @a root, and apply the experiment's limits. The
+  /// root must be a cgroup v2 directory delegated to this user.
+  CgroupLeaf(const boost::filesystem::path &root, const std::string &name,
+      const Experiment &exp, const CpuSet &cpus);
+
+  CgroupLeaf(const CgroupLeaf &) = delete;
+  CgroupLeaf &operator=(const CgroupLeaf &) = delete;
+
+  ~CgroupLeaf();
+
+  const boost::filesystem::path &path() const { return path_; }
+
+  /// Path of cgroup.procs, written to move a process into this cgroup
+  const char *procs() const { return procs_.c_str(); }
+
+  /// Check if the kernel's OOM killer killed anything in this cgroup
+  bool oom_killed() const;
+
+  /// Enable the cpu, cpuset, and memory controllers for children of @a root
+  static void enable_controllers(const boost::filesystem::path &root);
+};
+
+/// The CPUs and cgroup reserved for one trial, released when destroyed.
+/// Must outlive the spawn of the executor it is applied to.
+class TrialResources
+{
+private:
+  CpuAllocator *alloc_ = nullptr;
+  CpuSet owned_;
+  CpuSet cpus_;
+  cpu_set_t mask_;
+  std::unique_ptr<CgroupLeaf> cgroup_;
+
+public:
+  /// Reserve resources for a trial of @a exp. If @a cgroup_root is empty, no
+  /// cgroup is created. @a name names the cgroup.
+  TrialResources(CpuAllocator &alloc, const std::string &cgroup_root,
+      const std::string &name, const Experiment &exp);
+
+  TrialResources(const TrialResources &) = delete;
+  TrialResources &operator=(const TrialResources &) = delete;
+
+  ~TrialResources();
+
+  /// CPUs the executor is limited to, or empty if unrestricted
+  const CpuSet &cpus() const { return cpus_; }
+
+  bool oom_killed() const { return cgroup_ && cgroup_->oom_killed(); }
+
+  /// Apply to the calling process: called in the forked executor, before
+  /// exec. Only makes async-signal-safe calls, and ignores failures.
+  void apply() const;
+
+  /// Check if an experiment asks for any resource hints at all
+  static bool wanted(const Experiment &exp);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_RESOURCES_HPP
@@ -1,6 +1,8 @@
 #ifndef INCL_ROYALE_RUNNER_HPP
 #define INCL_ROYALE_RUNNER_HPP
 
+#include <deque>
+#include <set>
 #include <utility>
 #include <boost/asio/spawn.hpp>
 #include <boost/process.hpp>
@@ -8,6 +10,25 @@
 #include "royale/util.hpp"
 #include "royale/Experiment.hpp"
 #include "royale/Trial.hpp"
+#include "royale/ExecutorPool.hpp"
+#include "royale/PluginPool.hpp"
+#include "royale/LaunchPlan.hpp"
+#include "royale/Resources.hpp"
+#include "royale/Capture.hpp"
+#include "royale/RuntimeStats.hpp"
+#include "royale/SequentialTest.hpp"
+#include "royale/IntervalEstimate.hpp"
+#include "royale/NdjsonWriter.hpp"
+#include "royale/Journal.hpp"
+#include "royale/MemoCache.hpp"
+#include "royale/Enumeration.hpp"
+#include "royale/Splitting.hpp"
+#include "royale/ActiveSampler.hpp"
+#include "royale/TimeBudget.hpp"
+#include "royale/SampleAllocator.hpp"
+#include "royale/MemFd.hpp"
+#include "royale/TrialOutputParser.hpp"
+#include "royale/Zygote.hpp"
 
 namespace royale {
 
@@ -205,6 +226,7 @@ class Message::BatchDone
   ROYALE_JSON_FIELDS(BatchDone,
       (std::string, experiment_name)
       (std::vector<Trial>, trials)
+      (BlobStore::blobs_type, blobs)
     );
 
 public:
@@ -215,23 +237,137 @@ public:
 
   std::string &experiment_name() { return experiment_name_; }
   std::vector<Trial> &trials() { return trials_; }
+
+  /// Text externalized from the trials, each sent once however many trials
+  /// share it
+  BlobStore::blobs_type &blobs() { return blobs_; }
+  BatchDone &blobs(BlobStore::blobs_type blobs)
+  {
+    blobs_ = std::move(blobs);
+    return *this;
+  }
 };
 
 class Runner
 {
 public:
   using experiments_type = std::map<std::string, std::unique_ptr<Experiment>>;
+  using pools_type = std::map<std::string, std::unique_ptr<ExecutorPool>>;
+  using zygotes_type = std::map<std::string, std::shared_ptr<Zygote>>;
+  using plugin_pools_type =
+    std::map<std::string, std::unique_ptr<PluginPool>>;
+  using plans_type = std::map<std::string, LaunchPlan>;
   using stream_type = websocket::stream<tcp::socket>;
 private:
   experiments_type experiments_;
   io::io_context ioc_;//{new io::io_context{}};
+  plans_type plans_;
+  std::unique_ptr<CpuAllocator> cpu_allocator_;
+  bool cgroup_ready_ = false;
+  size_t trial_seq_ = 0;
+  pools_type pools_;
+  zygotes_type zygotes_;
+  plugin_pools_type plugin_pools_;
+  std::map<std::string, RuntimeStats> runtimes_;
+  std::map<std::string, size_t> drawn_;
+  std::map<std::string, std::deque<Trial>> pending_;
+
+  /// Samples of an experiment's inputs being walked in turn, by enumerate()
+  struct Enumerating
+  {
+    std::shared_ptr<InputEnumeration> space;
+    size_t shard;
+    size_t shards;
+    size_t points;
+  };
+  std::map<std::string, Enumerating> enumerations_;
+  size_t backups_ = 0;
+  size_t in_flight_ = 0; // units of run_shared() work running, of `jobs`
+  SpeculationStats speculation_;
   Registry registry_;
   std::unique_ptr<stream_type> remote_;
 
 private:
+  ExecutorPool &executor_pool(const Experiment &exp);
+  PluginPool &plugin_pool(const Experiment &exp);
+  Zygote &zygote(const Experiment &exp);
+  std::shared_ptr<TrialResources> trial_resources(const Experiment &exp);
+
   void exec_experiment_impl(const Experiment &exp, Trial trial,
       std::function<void(Trial)> handler);
 
+  /// Run @a trial with the spawn protocol. Returns a function which kills
+  /// the executor, leaving @a handler to be called with its error.
+  std::function<void()> spawn_trial(const Experiment &exp, Trial trial,
+      std::function<void(Trial)> handler);
+
+  void race_trial_impl(const Experiment &exp, Trial trial,
+      std::function<void(Trial)> handler);
+
+  /// Run @a trial with the spawn protocol, and if it runs past the
+  /// `speculate` percentile of the experiment's recent run times, start a
+  /// copy, taking whichever finishes first. Copies only start while one of
+  /// the `jobs` slots is free, so they never oversubscribe the machine.
+  template<typename Handler>
+  auto race_trial(const Experiment &exp, Trial trial, Handler &&handler)
+  {
+    return xtd::do_async_func<void(Trial)>(
+        [&](std::function<void(Trial)> f) {
+          race_trial_impl(exp, std::move(trial), f);
+        },
+        std::forward<Handler>(handler));
+  }
+
+  void exec_batch_impl(const Experiment &exp, std::vector<Trial> trials,
+      std::function<void(std::vector<Trial>)> handler);
+
+  /// Run @a trials on one executor, per Experiment::batch_size
+  template<typename Handler>
+  auto exec_batch(const Experiment &exp, std::vector<Trial> trials,
+      Handler &&handler)
+  {
+    return xtd::do_async_func<void(std::vector<Trial>)>(
+        [&](std::function<void(std::vector<Trial>)> f) {
+          exec_batch_impl(exp, std::move(trials), f);
+        },
+        std::forward<Handler>(handler));
+  }
+
+  /// If @a exp is deterministic and the memo cache has @a trial, set its
+  /// status from there and return true
+  bool recall(const Experiment &exp, Trial &trial);
+
+  /// Keep @a trial in the memo cache, if @a exp is deterministic and the
+  /// trial completed
+  void remember(const Experiment &exp, const Trial &trial);
+
+  /// New trial of the named experiment, with a fresh sample of its inputs,
+  /// or the next left pending by resume() or queue()
+  Trial new_trial(const std::string &name);
+
+  /// What a spawned executor left behind
+  struct SpawnResult
+  {
+    int result = 0;
+    std::error_code ec;
+    double elapsed = 0;
+    std::string sout;
+    std::string serr;
+    Trial::files_type files;
+
+    /// Killed for exceeding Experiment::memory_max
+    bool oom = false;
+  };
+
+  /// Start the experiment's executor with @a input, and call @a handler once
+  /// it has exited and its output is closed. If @a on_stdout is given, it is
+  /// passed all of stdout as it arrives, beyond the capture limit. Returns a
+  /// function which kills the executor's process group, if still running.
+  std::function<void()> spawn_executor(const Experiment &exp,
+      std::string input,
+      std::function<void(const char *, size_t)> on_stdout,
+      std::function<void(SpawnResult)> handler);
+
   template<typename Handler>
   auto exec_experiment(const Experiment &exp, Trial trial, Handler &&handler)
   {
@@ -255,6 +391,8 @@ private:
       io::yield_context yield);
 
 public:
+  /// Add an experiment, resolving its command into a LaunchPlan. Changes to
+  /// the experiment's cmd, env, or cd after this won't affect its trials.
   Experiment &add_experiment(Experiment e);
 
   const experiments_type &experiments() const {
@@ -264,9 +402,61 @@ public:
   Trial run_trial(const std::string &name,
     io::yield_context yield, stream_type *stream = nullptr);
 
+  /// Run @a trial, already drawn with new_trial()
+  Trial run_trial(Trial trial, io::yield_context yield,
+    stream_type *stream = nullptr);
+
   std::vector<Trial> run_batch(const std::string &name,
     io::yield_context yield);
 
+  /// Pick up the named experiment's input sequence where an earlier run
+  /// stopped, given the TrialInput::seq of each trial it completed. The
+  /// experiment's inputs are sampled again up to the last of them, so seeded
+  /// inputs continue where they were, and samples of trials that didn't
+  /// complete are run first by later trials. Returns how many those are.
+  size_t resume(const std::string &name, const std::set<size_t> &done);
+
+  /// Have new trials of the named experiment take each sample of @a space,
+  /// the enumeration of its inputs, in turn, rather than random ones: those
+  /// numbered @a shard, @a shard + @a shards, and so on. Each trial's
+  /// TrialInput::weight is its sample's probability times the number of
+  /// samples. Returns the number of
+  /// samples in the shard; trials after that many start over.
+  size_t enumerate(const std::string &name,
+      std::shared_ptr<InputEnumeration> space, size_t shard, size_t shards);
+
+  /// Have the next new trials of the named experiment be @a trials, prepared
+  /// by the caller, as for MultilevelSplitting, before any fresh samples.
+  /// Their TrialInput::seq is numbered on from those already drawn.
+  void queue(const std::string &name, std::vector<Trial> trials);
+
+  /// Run @a count trials of the named experiment, keeping up to `jobs` of
+  /// them in flight at once. @a on_trial is called with each Trial as it
+  /// completes, in completion order. Returns once all have completed. Local
+  /// trials are run Experiment::batch_size at a time, if set. If @a stop is
+  /// given, no more trials are started once it returns true.
+  void run_trials(const std::string &name, size_t count,
+    std::function<void(Trial)> on_trial, io::yield_context yield,
+    std::function<bool()> stop = nullptr);
+
+  /// Trials of an experiment for run_shared() to run, and its weight
+  struct Share
+  {
+    size_t count = 0;
+    double weight = 1;
+  };
+  using shares_type = std::map<std::string, Share>;
+
+  /// Run trials of several experiments together, as run_trials() does for
+  /// one, so each makes progress from the start. Each free slot goes to the
+  /// experiment with trials left that has the fewest in flight for its
+  /// weight, breaking ties by fewest started for its weight. Experiments
+  /// share the slots by weight while all have trials left, and slots any
+  /// can't use go to the others.
+  void run_shared(const shares_type &shares,
+    std::function<void(Trial)> on_trial, io::yield_context yield,
+    std::function<bool()> stop = nullptr);
+
   template<typename Func>
   void spawn(Func func)
   {
@@ -292,6 +482,34 @@ public:
 
   int pretty = -1;
   std::string cd;
+
+  /// Maximum number of local trials to run concurrently in run_trials
+  size_t jobs = 1;
+
+  /// Delegated cgroup v2 directory, under which each spawned trial with
+  /// resource hints gets its own cgroup. If empty, only CPU affinity is used.
+  std::string cgroup;
+
+  /// Limits on executor output kept per trial
+  CaptureConfig capture;
+
+  /// Executor output and aux values at least this many bytes are sent in
+  /// batches, and written to results, as blobs, by digest
+  size_t blob_min = 64;
+
+  /// If positive, local spawned trials running past this percentile of their
+  /// experiment's recent run times are started again on a free `jobs` slot,
+  /// if any, taking whichever copy finishes first
+  double speculate = 0;
+
+  const SpeculationStats &speculation() const { return speculation_; }
+
+  /// Cache of deterministic experiments' trials, or null for none
+  std::unique_ptr<MemoCache> memo;
+
+  /// If set, results are written with executor output and large aux values
+  /// held here, by digest
+  std::unique_ptr<BlobStore> blobs;
 };
 
 } // namespace royale
@@ -0,0 +1,51 @@
+#ifndef INCL_ROYALE_RUNTIMESTATS_HPP
+#define INCL_ROYALE_RUNTIMESTATS_HPP
+
+#include <vector>
+#include "royale/util.hpp"
+
+namespace royale {
+
+/// Recent trial run times of one experiment, for spotting stragglers
+class RuntimeStats
+{
+private:
+  std::vector<double> window_;
+  size_t next_ = 0;
+  size_t max_;
+
+public:
+  /// Keep the last @a window run times
+  explicit RuntimeStats(size_t window = 1000) : max_(window) {}
+
+  void add(double seconds);
+
+  /// Number of run times kept
+  size_t count() const { return window_.size(); }
+
+  /// Run time which @a p percent of kept run times are at or below, or 0 if
+  /// none are kept
+  double percentile(double p) const;
+};
+
+/// Counts of speculative re-execution, for --stats
+class SpeculationStats
+{
+  ROYALE_JSON_FIELDS(SpeculationStats,
+      (size_t, launched, 0)
+      (size_t, won, 0)
+    );
+
+public:
+  /// Backup copies of straggling trials started
+  size_t launched() const { return launched_; }
+  SpeculationStats &launched(size_t n) { launched_ = n; return *this; }
+
+  /// Backups which finished before the trial they copied
+  size_t won() const { return won_; }
+  SpeculationStats &won(size_t n) { won_ = n; return *this; }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_RUNTIMESTATS_HPP
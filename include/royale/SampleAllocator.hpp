@@ -0,0 +1,112 @@
+#ifndef INCL_ROYALE_SAMPLEALLOCATOR_HPP
+#define INCL_ROYALE_SAMPLEALLOCATOR_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Trials and predicate counts of one experiment under a SampleAllocator
+class ExperimentAllocation
+{
+public:
+  using preds_type = std::map<std::string, PredicateOutput>;
+
+  ROYALE_JSON_FIELDS(ExperimentAllocation,
+      (size_t, trials, 0)
+      (double, half_width, 0.5)
+      (preds_type, preds)
+    );
+
+public:
+  /// Trials of the experiment counted so far
+  size_t trials() const { return trials_; }
+  ExperimentAllocation &trials(size_t trials)
+  {
+    trials_ = trials;
+    return *this;
+  }
+
+  /// Widest half-width of its predicates' intervals, 0.5 before any have
+  /// been seen
+  double half_width() const { return half_width_; }
+  ExperimentAllocation &half_width(double half_width)
+  {
+    half_width_ = half_width;
+    return *this;
+  }
+
+  const preds_type &preds() const { return preds_; }
+  preds_type &preds() { return preds_; }
+};
+
+/// Splits a budget of trials among experiments so as to narrow the widest
+/// confidence interval of any of their predicates, rather than running each
+/// the same number of times: predicates with probabilities near 0 or 1 need
+/// far fewer trials than those near 0.5.
+///
+/// Trials are handed out a round at a time by next(), each to whichever
+/// experiment's widest interval would then still be widest, projected from
+/// its predicates' running probabilities. Experiments not yet tried are
+/// taken to have a predicate at 0.5.
+class SampleAllocator
+{
+public:
+  using experiments_type = std::map<std::string, ExperimentAllocation>;
+  using counts_type = std::map<std::string, size_t>;
+
+  ROYALE_JSON_FIELDS(SampleAllocator,
+      (size_t, budget, 0)
+      (size_t, spent, 0)
+      (std::string, method, "wilson")
+      (double, confidence, 0.95)
+      (double, half_width, 0.5)
+      (experiments_type, experiments)
+    );
+
+public:
+  SampleAllocator() = default;
+
+  /// Allocator of @a budget trials among @a experiments, measuring
+  /// intervals by @a method at @a confidence, as for IntervalEstimate.
+  /// Throws if there are no experiments, or the method is unknown.
+  SampleAllocator(const std::vector<std::string> &experiments, size_t budget,
+      double confidence = 0.95, std::string method = "wilson");
+
+  /// Trials in the whole budget, and counted by add() so far
+  size_t budget() const { return budget_; }
+  size_t spent() const { return spent_; }
+
+  /// True once the whole budget has been spent
+  bool done() const { return spent_ >= budget_; }
+
+  /// Widest half-width of any experiment's predicate intervals
+  double half_width() const { return half_width_; }
+
+  const experiments_type &experiments() const { return experiments_; }
+
+  /// Hand out up to @a n more trials of what's left of the budget: how many
+  /// to run of each experiment, leaving out those to run none. Nothing is
+  /// spent until the trials are add()ed, so with -B/--batch, where a batch
+  /// runs as many trials as there are runners, ask for 1 and run a batch of
+  /// the experiment given.
+  counts_type next(size_t n);
+
+  /// Update from a completed trial. Trials without a predicate, such as
+  /// failed ones, are counted as its errors.
+  void add(const Trial &trial);
+
+private:
+  /// Widest half-width of the experiment's intervals after @a extra more
+  /// trials, if its predicates' probabilities stay as they are
+  double projected(const ExperimentAllocation &exp, size_t extra) const;
+
+  void update(ExperimentAllocation &exp);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_SAMPLEALLOCATOR_HPP
@@ -0,0 +1,70 @@
+#ifndef INCL_ROYALE_SEQUENTIALTEST_HPP
+#define INCL_ROYALE_SEQUENTIALTEST_HPP
+
+#include <string>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Wald's sequential probability ratio test of whether a predicate's
+/// probability is at least (">=") or at most ("<=") a bound, updated as
+/// trials complete, so a run can stop as soon as there's enough evidence
+/// either way.
+///
+/// For "p >= theta", the test weighs p >= theta + indifference against
+/// p <= theta - indifference, with error rates alpha (deciding "fails" when
+/// the property holds) and beta (deciding "holds" when it fails). Within the
+/// indifference region, either decision is acceptable.
+class SequentialTest
+{
+  ROYALE_JSON_FIELDS(SequentialTest,
+      (std::string, pred)
+      (std::string, op, ">=")
+      (double, bound, 0)
+      (double, alpha, 0.05)
+      (double, beta, 0.05)
+      (double, indifference, 0.01)
+      (double, llr, 0)
+      (std::string, decision, "undecided")
+      (PredicateOutput, output)
+    );
+
+public:
+  SequentialTest() = default;
+
+  /// Test of @a spec, like "acute >= 0.3". Throws if it can't be parsed, or
+  /// the hypotheses it gives aren't within (0, 1).
+  SequentialTest(const std::string &spec, double alpha, double beta,
+      double indifference);
+
+  const std::string &pred() const { return pred_; }
+  const std::string &op() const { return op_; }
+  double bound() const { return bound_; }
+  double alpha() const { return alpha_; }
+  double beta() const { return beta_; }
+  double indifference() const { return indifference_; }
+
+  /// Log-likelihood ratio of the property failing over it holding, so far
+  double llr() const { return llr_; }
+
+  /// "holds", "fails", or "undecided"
+  const std::string &decision() const { return decision_; }
+  bool decided() const { return decision_ != "undecided"; }
+
+  /// Counts of the predicate over trials seen so far
+  const PredicateOutput &output() const { return output_; }
+
+  /// Update from a completed trial. Trials without the predicate, such as
+  /// failed ones, are counted as errors, and don't move the test. Its
+  /// TrialInput::weight is ignored, so trials must be drawn from the
+  /// experiment's own inputs. Returns decided().
+  bool add(const Trial &trial);
+
+  /// Update from one observation of the predicate
+  bool add(bool sat);
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_SEQUENTIALTEST_HPP
@@ -0,0 +1,124 @@
+#ifndef INCL_ROYALE_SPLITTING_HPP
+#define INCL_ROYALE_SPLITTING_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Fixed-effort multilevel splitting, for rare events at the end of long
+/// simulated trajectories, where reweighting inputs doesn't help.
+///
+/// Executors report how far a trajectory got as a progress score, and each
+/// run stops once its score reaches a level. Each stage runs effort()
+/// trajectories, starting from copies of those which reached the last
+/// level; the fraction reaching the next level estimates the probability
+/// of getting there, given the last. The estimate of the rare event, of
+/// reaching the top level, is their product.
+///
+/// Trajectories are passed through the replicate fields. Each trial's input
+/// replicate is {"level": L, "state": S, "seed": N}: run until the score
+/// reaches L, starting from state S (null for a new trajectory), using
+/// random seed N. Its output replicate must be {"score": X, "state": T}:
+/// the highest score reached, and if that's at least L, the state at which
+/// it first did, to start copies from.
+class MultilevelSplitting
+{
+public:
+  using levels_type = std::vector<double>;
+  using counts_type = std::vector<size_t>;
+  using probs_type = std::vector<double>;
+
+  ROYALE_JSON_FIELDS(MultilevelSplitting,
+      (levels_type, levels)
+      (size_t, effort, 0)
+      (size_t, stage, 0)
+      (counts_type, runs)
+      (counts_type, hits)
+      (size_t, error_count, 0)
+      (probs_type, level_probs)
+      (double, prob, 0)
+      (double, rel_error, 0)
+      (bool, stopped, false)
+    );
+
+private:
+  struct Start
+  {
+    TrialInput::sample_type sample;
+    json state;
+    double score;
+  };
+
+  std::vector<Start> starts_;
+  std::vector<Start> reached_;
+  std::mt19937_64 random_;
+
+public:
+  MultilevelSplitting() = default;
+
+  /// Splitting over increasing @a levels of progress score, the last being
+  /// the rare event, with @a effort trajectories per stage. Throws if the
+  /// levels don't increase, or effort is 0.
+  MultilevelSplitting(levels_type levels, size_t effort,
+      unsigned int seed = std::random_device()());
+
+  const levels_type &levels() const { return levels_; }
+  size_t effort() const { return effort_; }
+
+  /// Index of the level the current stage's trajectories are trying to
+  /// reach
+  size_t stage() const { return stage_; }
+
+  /// Trajectories run, and those reaching the level, at each stage so far
+  const counts_type &runs() const { return runs_; }
+  const counts_type &hits() const { return hits_; }
+
+  /// Trials whose output had no score; they're left out of the counts
+  size_t error_count() const { return error_count_; }
+
+  /// Estimated probability of reaching each level from the last
+  const probs_type &level_probs() const { return level_probs_; }
+
+  /// Estimated probability of reaching the top level
+  double prob() const { return prob_; }
+
+  /// Estimated relative standard error of prob(), treating stages as
+  /// independent
+  double rel_error() const { return rel_error_; }
+
+  /// True if stop() cut the run short, before the top level was tried.
+  /// prob() then estimates reaching only the last level tried.
+  bool stopped() const { return stopped_; }
+
+  /// True once the top level has been tried, or no trajectory reached a
+  /// level, or stop() was called
+  bool done() const
+  {
+    return stopped_ || stage_ >= levels_.size() ||
+      (stage_ > 0 && hits_[stage_ - 1] == 0);
+  }
+
+  /// Stop early, as when out of time, finishing the current stage with the
+  /// trials added so far, if any
+  void stop();
+
+  /// Trials of @a exp for the current stage: new trajectories at first,
+  /// then copies of those which reached the last level, the furthest along
+  /// getting any extra copies
+  std::vector<Trial> stage_trials(const Experiment &exp);
+
+  /// Count a trial of the current stage
+  void add(const Trial &trial);
+
+  /// Finish the current stage, updating the estimates
+  void next_stage();
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_SPLITTING_HPP
@@ -0,0 +1,60 @@
+#ifndef INCL_ROYALE_TIMEBUDGET_HPP
+#define INCL_ROYALE_TIMEBUDGET_HPP
+
+#include <chrono>
+#include <string>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Wall-clock budget for a run: trials are started until it expires, those
+/// in flight are then left to finish, and the trials completed and their
+/// throughput are reported.
+class TimeBudget
+{
+  ROYALE_JSON_FIELDS(TimeBudget,
+      (double, seconds, 0)
+      (double, elapsed, 0)
+      (size_t, trials, 0)
+      (double, throughput, 0)
+    );
+
+  std::chrono::steady_clock::time_point started_at_;
+  bool started_ = false;
+
+public:
+  TimeBudget() = default;
+
+  /// Budget of @a spec: a number of seconds, or of minutes or hours with an
+  /// "m" or "h" suffix, like "30m". Throws if it can't be parsed, or isn't
+  /// positive.
+  explicit TimeBudget(const std::string &spec);
+
+  /// Length of the budget, in seconds
+  double seconds() const { return seconds_; }
+
+  /// Seconds from start() to finish()
+  double elapsed() const { return elapsed_; }
+
+  /// Trials completed, and their number per second, by finish()
+  size_t trials() const { return trials_; }
+  double throughput() const { return throughput_; }
+
+  /// Start the clock, if not already started
+  void start();
+
+  /// True once the budget has passed since start()
+  bool expired() const;
+
+  /// Count a completed trial
+  void add(const Trial &) { ++trials_; }
+
+  /// Stop the clock, once trials in flight have finished, and work out
+  /// throughput()
+  void finish();
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_TIMEBUDGET_HPP
@@ -8,6 +8,7 @@
 #include "royale/util.hpp"
 #include "royale/TrialInput.hpp"
 #include "royale/ErrorKind.hpp"
+#include "royale/Blob.hpp"
 
 namespace io = boost::asio;
 
@@ -27,6 +28,13 @@ public:
   virtual StatusCode code() const = 0;
   virtual bool final() const { return false; }
 
+  /// Move executor output, and large values in aux, of at least @a min_size
+  /// bytes into @a store, leaving only their digests
+  virtual void externalize(BlobStore &, size_t) {}
+
+  /// Load everything externalized back from @a store
+  virtual void internalize(const BlobStore &) {}
+
   ROYALE_JSON_ENUM(TrialStatus, Created, InProgress, Error, Complete);
 };
 
@@ -46,6 +54,25 @@ public:
   const preds_type &preds() const { return preds_; }
   const aux_type &aux() const { return aux_; }
   const json &replicate() const { return replicate_; }
+
+  preds_type &preds() { return preds_; }
+  aux_type &aux() { return aux_; }
+  json &replicate() { return replicate_; }
+
+  /// Value of aux field @a key, loaded from BlobStore::default_store() if it
+  /// was externalized. Throws if there's no such field.
+  json aux(const std::string &key) const;
+
+  /// Replace aux values whose JSON is at least @a min_size bytes with
+  /// {"$blob": digest}, keeping their JSON in @a store
+  void externalize_aux(BlobStore &store, size_t min_size);
+
+  /// Throw if an aux value is an object with a "$blob" key, which executors
+  /// mustn't produce, as it would be taken for an externalized value
+  void check_aux() const;
+
+  /// Load externalized aux values back from @a store
+  void internalize_aux(const BlobStore &store);
 };
 
 class TrialStatus::Created : public xtd::EnableJsonObject<Created, TrialStatus>
@@ -86,13 +113,27 @@ public:
   {
     v.kind_ = j;
   }
+
+  void externalize(BlobStore &store, size_t min_size) override
+  {
+    if (kind_) {
+      kind_->for_each_blob([&](Blob &b) { b.externalize(store, min_size); });
+    }
+  }
+
+  void internalize(const BlobStore &store) override
+  {
+    if (kind_) {
+      kind_->for_each_blob([&](Blob &b) { b.internalize(store); });
+    }
+  }
 };
 
 class TrialStatus::Complete : public xtd::EnableJsonObject<Complete, TrialStatus>
 {
   ROYALE_JSON_FIELDS(Complete,
       (TrialOutput, output)
-      (std::string, stderr)
+      (Blob, stderr)
     );
 
 public:
@@ -100,17 +141,34 @@ public:
   virtual bool final() const { return true; }
 
   Complete() = default;
-  Complete(TrialOutput output, std::string stderr = "")
+  Complete(TrialOutput output, Blob stderr = "")
     : output_(output), stderr_(stderr) {}
 
   const TrialOutput &output() const { return output_; }
+  const Blob &stderr() const { return stderr_; }
+
+  void externalize(BlobStore &store, size_t min_size) override
+  {
+    stderr_.externalize(store, min_size);
+    output_.externalize_aux(store, min_size);
+  }
+
+  void internalize(const BlobStore &store) override
+  {
+    stderr_.internalize(store);
+    output_.internalize_aux(store);
+  }
 };
 
 class Trial
 {
+public:
+  using files_type = std::map<std::string, std::string>;
+private:
   ROYALE_JSON_FIELDS(Trial,
       (TrialStatus::Enum, status, TrialStatus::Created::mk())
       (TrialInput, input)
+      (files_type, files)
     );
 
 public:
@@ -142,11 +200,29 @@ public:
   }
 
   const TrialStatus::Enum &status() const { return status_; }
+
+  /// Files holding whole executor output streams which were too large to
+  /// keep in the status, keyed by stream name ("stdout" or "stderr")
+  const files_type &files() const { return files_; }
+  files_type &files() { return files_; }
   Trial &status(TrialStatus::Enum status)
   {
     status_ = std::move(status);
     return *this;
   }
+
+  /// Move large text in the status into @a store; see TrialStatus
+  Trial &externalize(BlobStore &store, size_t min_size)
+  {
+    status_->externalize(store, min_size);
+    return *this;
+  }
+
+  Trial &internalize(const BlobStore &store)
+  {
+    status_->internalize(store);
+    return *this;
+  }
 };
 
 
@@ -223,6 +299,8 @@ public:
   Complete() = default;
   explicit Complete(AnalysisOutput::Enum output, std::string stderr = "")
     : output_(std::move(output)), stderr_(stderr) {}
+
+  const AnalysisOutput::Enum &output() const { return output_; }
 };
 
 class AnalysisInput : public xtd::EnableJsonObject<AnalysisInput>
@@ -318,9 +396,21 @@ class PredicateOutput : public xtd::EnableJsonObject<PredicateOutput>
       (size_t, count, 0)
       (double, prob, 0)
       (double, rel_error, 0)
+      (double, confidence, 0)
+      (double, lower, 0)
+      (double, upper, 1)
+      (bool, weighted, false)
+      (double, sat_weight, 0)
+      (double, sat_weight_sq, 0)
     );
 public:
   const std::string &name() const { return name_; }
+  PredicateOutput &name(std::string name)
+  {
+    name_ = std::move(name);
+    return *this;
+  }
+
   size_t sat_count() const { return sat_count_; }
   size_t error_count() const { return error_count_; }
   size_t count() const { return count_; }
@@ -328,16 +418,46 @@ public:
   double error_prob() const { return prob_; }
   double rel_error() const { return rel_error_; }
 
-  void add_sat()
+  /// Confidence level of [lower(), upper()], or 0 if interval() hasn't been
+  /// called
+  double confidence() const { return confidence_; }
+  double lower() const { return lower_; }
+  double upper() const { return upper_; }
+
+  /// Half the width of [lower(), upper()]
+  double half_width() const { return (upper_ - lower_) / 2; }
+
+  /// True if any sat trial had a weight other than 1, as from importance
+  /// sampling. prob() is then the mean of the weights of sat trials (0 for
+  /// unsat ones), rather than the fraction of trials which were sat.
+  bool weighted() const { return weighted_; }
+
+  /// Sum of the weights of sat trials, and of their squares
+  double sat_weight() const { return sat_weight_; }
+  double sat_weight_sq() const { return sat_weight_sq_; }
+
+  /// Set lower() and upper() to a @a confidence interval of prob(), by
+  /// @a method "wilson" or "clopper-pearson", and rel_error() to its
+  /// half_width() over prob() (left 0 while prob() is 0). Throws on an
+  /// unknown method. If weighted(), the interval is the normal approximation
+  /// from the weights' sample variance, whatever the method.
+  PredicateOutput &interval(const std::string &method, double confidence);
+
+  /// Count a sat trial, of TrialInput::weight @a weight
+  void add_sat(double weight = 1)
   {
     ++sat_count_;
+    sat_weight_ += weight;
+    sat_weight_sq_ += weight * weight;
+    weighted_ = weighted_ || weight != 1;
     add_unsat();
   }
 
-  void add_unsat()
+  /// Count an unsat trial. Its weight doesn't matter: it adds 0 to the mean.
+  void add_unsat(double = 1)
   {
     ++count_;
-    prob_ = sat_count_ / (double)(count_ - error_count_);
+    prob_ = sat_weight_ / (count_ - error_count_);
   }
 
   void add_error()
@@ -379,6 +499,7 @@ public:
   LogisticRegression(preds_type preds)
     : preds_(std::move(preds)) {}
 
+  const preds_type &preds() const { return preds_; }
   preds_type &preds() { return preds_; }
 };
 
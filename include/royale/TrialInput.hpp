@@ -19,6 +19,9 @@ public:
       (std::string, experiment_name)
       (sample_type, sample)
       (json, replicate)
+      (double, deadline, 0)
+      (size_t, seq, 0)
+      (double, weight, 1)
     );
 
 public:
@@ -48,6 +51,26 @@ public:
 
   const json &replicate() const { return replicate_; }
   TrialInput &replicate(json r) { replicate_ = std::move(r); return *this; }
+
+  /// Soft limit, in seconds, on how long the executor should run, or 0 if
+  /// unlimited. Executors should stop on their own before this; the runner
+  /// kills them once the experiment's full timeout passes.
+  double deadline() const { return deadline_; }
+  TrialInput &deadline(double d) { deadline_ = d; return *this; }
+
+  /// Number of samples drawn from the experiment's inputs before this one,
+  /// in this run. Replaying that many draws restores seeded inputs' random
+  /// generators to just before this trial.
+  size_t seq() const { return seq_; }
+  TrialInput &seq(size_t n) { seq_ = n; return *this; }
+
+  /// How much this trial counts towards estimates of the experiment's
+  /// probabilities: the likelihood ratio of its sample under the experiment's
+  /// inputs over how it was drawn. That's 1 for random samples, and for
+  /// samples from an enumeration of all of them, the sample's probability
+  /// times their number.
+  double weight() const { return weight_; }
+  TrialInput &weight(double w) { weight_ = w; return *this; }
 };
 
 } // namespace royale
@@ -0,0 +1,96 @@
+#ifndef INCL_ROYALE_TRIALOUTPUTPARSER_HPP
+#define INCL_ROYALE_TRIALOUTPUTPARSER_HPP
+
+#include <string>
+#include <vector>
+#include "royale/util.hpp"
+#include "royale/Trial.hpp"
+
+namespace royale {
+
+/// Incremental parser for the TrialOutput JSON an executor writes to stdout.
+/// Chunks are fed as they are read from the pipe, and parsed straight into
+/// TrialOutput's preds and aux, so the output is already validated when the
+/// executor exits, without building a DOM of the whole document or keeping
+/// a copy of it.
+///
+/// Accepts the same documents as json::parse followed by conversion to
+/// TrialOutput, except that the document must be a JSON object.
+class TrialOutputParser
+{
+private:
+  enum class Lex { Ws, String, Escape, Unicode, Number, Literal, Done };
+  enum class Section { None, Preds, Aux, Replicate, Other };
+
+  struct Frame
+  {
+    bool object;
+    int expect;
+  };
+
+  /// Builds a json value from parse events, for aux and replicate
+  struct Builder
+  {
+    json *root = nullptr;
+    std::vector<json *> stack;
+    std::string key;
+
+    json &place(json v);
+  };
+
+  TrialOutput output_;
+  std::string error_;
+
+  Lex lex_ = Lex::Ws;
+  std::string token_;
+  unsigned unicode_ = 0;
+  int unicode_digits_ = 0;
+  unsigned high_surrogate_ = 0;
+  bool string_is_key_ = false;
+
+  std::vector<Frame> stack_;
+  bool started_ = false;
+
+  Section section_ = Section::None;
+  std::string key2_;
+  Builder builder_;
+  int builder_depth_ = -1;
+  json discard_;
+
+  void fail(const std::string &msg);
+
+  void punct(char c);
+  void scalar(json v);
+  void start(bool object);
+  void end(bool object);
+  void key(std::string k);
+
+  bool begin_value();
+  void after_value();
+  bool route_value(int kind, const json *v);
+
+  void finish_number();
+  void finish_literal();
+  void finish_string();
+  void append_utf8(unsigned cp);
+
+public:
+  TrialOutputParser() = default;
+
+  /// Parse the next chunk of output. Never throws; check failed().
+  void feed(const char *data, size_t n);
+
+  /// Call at end of output. Returns true if a whole TrialOutput was parsed.
+  bool finish();
+
+  bool failed() const { return error_ != ""; }
+
+  /// Description of the first error found, if failed()
+  const std::string &error() const { return error_; }
+
+  TrialOutput &output() { return output_; }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_TRIALOUTPUTPARSER_HPP
@@ -5,6 +5,7 @@
 #include <utility>
 #include <vector>
 #include <map>
+#include <cmath>
 #include <random>
 #include <boost/lexical_cast.hpp>
 #include <royale/util.hpp>
@@ -22,10 +23,36 @@ public:
 
   struct Enum;
 
+  /// Possible values, with their probabilities
+  using support_type = std::map<Value, double>;
+
+  /// Most values a spec may have for finite_support() to list them
+  static constexpr size_t max_support = 1 << 16;
+
   /// Return true if to_json on ValueSpec::Enum should save this
   /// object directly as a single json entity, rather than a nested map.
   virtual bool save_direct_value() const { return false; }
   virtual Value sample() const = 0;
+
+  /// Probability density of sample() giving @a v; for discrete values, such
+  /// as from UniformInt, the probability of @a v itself. Used for the
+  /// likelihood ratios of importance sampling. Throws if not known.
+  virtual double density(const Value &v) const
+  {
+    (void)v;
+    throw std::runtime_error(std::string(virt_type_name()) +
+        " has no known density, for importance sampling");
+  }
+
+  /// If sample() has finitely many (at most max_support) possible values,
+  /// add each to @a support, with its probability times @a weight, and
+  /// return true. Otherwise, return false.
+  virtual bool finite_support(support_type &support, double weight = 1) const
+  {
+    (void)support;
+    (void)weight;
+    return false;
+  }
 };
 
 class ValueSpec::Constant : public xtd::EnableJsonObject<Constant, ValueSpec>
@@ -50,6 +77,17 @@ public:
     return val_;
   }
 
+  double density(const Value &v) const override
+  {
+    return v == val_ ? 1 : 0;
+  }
+
+  bool finite_support(support_type &support, double weight = 1) const override
+  {
+    support[val_] += weight;
+    return true;
+  }
+
 protected:
   friend void to_json(json &j, const Constant &v)
   {
@@ -117,6 +155,15 @@ public:
     return ret;
   }
 
+  double density(const Value &v) const override
+  {
+    const double *x = boost::get<double>(&v);
+    if (!x || *x < range_[0] || *x > range_[1]) {
+      return 0;
+    }
+    return range_[1] > range_[0] ? 1 / (range_[1] - range_[0]) : 1;
+  }
+
   Uniform() : range_{{0, 1}}, random_(gen_seed(seed_)) {}
   Uniform(double low, double high, unsigned int seed = -1U)
     : range_{{low, high}},
@@ -184,6 +231,27 @@ public:
     return dist(random_);
   }
 
+  double density(const Value &v) const override
+  {
+    const double *x = boost::get<double>(&v);
+    if (!x || *x < range_[0] || *x > range_[1] || *x != std::floor(*x)) {
+      return 0;
+    }
+    return 1.0 / (int64_t(range_[1]) - range_[0] + 1);
+  }
+
+  bool finite_support(support_type &support, double weight = 1) const override
+  {
+    int64_t n = int64_t(range_[1]) - range_[0] + 1;
+    if (n <= 0 || n > int64_t(max_support)) {
+      return false;
+    }
+    for (int64_t i = range_[0]; i <= range_[1]; ++i) {
+      support[double(i)] += weight / n;
+    }
+    return true;
+  }
+
   UniformInt() : range_{{0, 1}}, random_(gen_seed(seed_)) {}
   UniformInt(int low, int high, unsigned int seed = -1U)
     : range_{{low, high}},
@@ -260,6 +328,33 @@ public:
     }
   }
 
+  double density(const Value &v) const override
+  {
+    if (options_.empty()) {
+      return v == Value(std::string("<empty>")) ? 1 : 0;
+    }
+    double ret = 0;
+    for (const auto &option : options_) {
+      ret += option->density(v);
+    }
+    return ret / options_.size();
+  }
+
+  bool finite_support(support_type &support, double weight = 1) const override
+  {
+    if (options_.empty()) {
+      support["<empty>"] += weight;
+      return true;
+    }
+    for (const auto &option : options_) {
+      if (!option->finite_support(support, weight / options_.size()) ||
+          support.size() > max_support) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   Choose() : random_(gen_seed(seed_)) {}
 
   Choose(options_type &&i, unsigned int seed = -1U)
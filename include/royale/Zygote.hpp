@@ -0,0 +1,85 @@
+#ifndef INCL_ROYALE_ZYGOTE_HPP
+#define INCL_ROYALE_ZYGOTE_HPP
+
+#include <map>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/asio/generic/seq_packet_protocol.hpp>
+#include <boost/process.hpp>
+#include "royale/util.hpp"
+#include "royale/Experiment.hpp"
+#include "royale/LaunchPlan.hpp"
+#include "royale/Capture.hpp"
+
+namespace royale {
+
+namespace io = boost::asio;
+namespace bp = boost::process;
+
+struct ZygoteJob;
+
+/// A fork server for one experiment. The executor is started once, with
+/// ROYALE_PROTOCOL=zygote, and initializes itself. For each trial, the runner
+/// sends a request over a control socket (fd ROYALE_CONTROL_FD) carrying
+/// fresh stdin, stdout and stderr pipes; the executor forks a child which
+/// runs the trial on those pipes, exactly as a spawned executor would.
+///
+/// Control messages are one JSON object per packet. The executor sends
+/// {"ready": true} once initialized, {"id": N, "pid": P} once it has forked
+/// request N, and {"id": N, "status": S} when that child exits, where S is
+/// the exit code, or the negated signal number if killed by a signal. The
+/// child should make itself a process group leader, so it can be killed along
+/// with anything it starts.
+class Zygote : public std::enable_shared_from_this<Zygote>
+{
+public:
+  using socket_type = io::generic::seq_packet_protocol::socket;
+  using files_type = std::map<std::string, std::string>;
+  using handler_type = std::function<void(int result,
+      const std::error_code &ec, std::string sout, std::string serr,
+      files_type files)>;
+private:
+  io::io_context *ioc_;
+  std::string name_;
+  CaptureConfig capture_;
+  std::unique_ptr<bp::child> child_;
+  socket_type control_;
+  std::array<char, 4096> buf_;
+  io::socket_base::message_flags flags_;
+  bool ready_ = false;
+  bool dead_ = false;
+  std::vector<std::function<void()>> waiting_;
+  std::map<uint64_t, std::shared_ptr<ZygoteJob>> pending_;
+  uint64_t next_id_ = 0;
+
+  void read_control();
+  void handle_message(const json &msg);
+  void fail(const std::error_code &ec);
+
+public:
+  Zygote(io::io_context &ioc, const Experiment &exp,
+      const LaunchPlan &plan, CaptureConfig capture);
+
+  Zygote(const Zygote &) = delete;
+  Zygote &operator=(const Zygote &) = delete;
+
+  ~Zygote();
+
+  /// Begin reading control messages. Must be called once, after
+  /// construction into a shared_ptr.
+  void start() { read_control(); }
+
+  /// Run one trial, writing @a input to the forked child's stdin. The
+  /// handler is called with the child's exit status and output, and any
+  /// spill files of its output, once the child has exited and closed its
+  /// output. If @a timeout is positive, the
+  /// child's process group is killed after that many seconds, and the
+  /// handler is given std::errc::timed_out.
+  void run(std::string input, double timeout, handler_type handler);
+
+  bool alive() const { return !dead_; }
+};
+
+} // namespace royale
+
+#endif // INCL_ROYALE_ZYGOTE_HPP
@@ -0,0 +1,35 @@
+#ifndef INCL_ROYALE_PLUGIN_H
+#define INCL_ROYALE_PLUGIN_H
+
+/* C interface for in-process executors ("plugin" experiments). A plugin is a
+ * shared library exporting royale_run. It must not depend on anything from
+ * Royale itself; only this header. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called by a plugin to return its output: TrialOutput JSON, as an executor
+ * would write to stdout. May be called more than once per trial, to write the
+ * output in pieces. */
+typedef void (*royale_output_fn)(void *ctx, const char *data, size_t len);
+
+/* Run one trial. input is TrialInput JSON, as an executor would read from
+ * stdin, of len bytes; it is not null-terminated. Write the output with
+ * output(ctx, ...) before returning. Return 0 on success; anything else is
+ * reported like an executor's nonzero exit status.
+ *
+ * Called concurrently from several threads, so it must be thread-safe. */
+int royale_run(const char *input, size_t len,
+    royale_output_fn output, void *ctx);
+
+typedef int (*royale_run_fn)(const char *input, size_t len,
+    royale_output_fn output, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCL_ROYALE_PLUGIN_H */
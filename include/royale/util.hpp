@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
 #include <nlohmann/json.hpp>
 #include <boost/variant.hpp>
 #include <boost/filesystem.hpp>
@@ -83,6 +84,20 @@ inline std::shared_ptr<decay<T>> into_shared(T&& t) {
   return std::make_shared<decay<T>>(std::forward<T>(t));
 }
 
+/// Convert a (possibly fractional) number of seconds to a clock duration
+inline std::chrono::steady_clock::duration to_duration(double seconds)
+{
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(seconds));
+}
+
+/// Seconds elapsed since @a start
+inline double seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
 template<typename T>
 inline std::string pretty_name() {
   return boost::typeindex::type_id<T>().pretty_name();
@@ -0,0 +1,141 @@
+#include <royale/ActiveSampler.hpp>
+
+#include <cmath>
+
+namespace royale {
+
+ActiveSampler::ActiveSampler(preds_type preds, size_t pool, double explore,
+    unsigned int seed)
+  : preds_(std::move(preds)), pool_(pool), explore_(explore), random_(seed)
+{
+  if (preds_.empty()) {
+    throw std::runtime_error("No predicates to sample for");
+  }
+  if (pool_ == 0) {
+    throw std::runtime_error("Active sampling pool must not be empty");
+  }
+  if (!(explore_ > 0 && explore_ <= 1)) {
+    throw std::runtime_error("Active sampling explore fraction must be "
+        "within (0, 1]");
+  }
+}
+
+double ActiveSampler::uncertainty(const TrialInput::sample_type &sample) const
+{
+  if (fits_.empty()) {
+    return 1;
+  }
+  double ret = 0;
+  for (const auto &fit : fits_) {
+    const auto &coeffs = fit.second;
+    auto intercept = coeffs.find("");
+    double z = intercept != coeffs.end() ? intercept->second : 0;
+    for (const auto &input : sample) {
+      auto coeff = coeffs.find(input.first);
+      if (coeff != coeffs.end()) {
+        z += coeff->second * xtd::dbl(input.second);
+      }
+    }
+    double p = 1 / (1 + std::exp(-z));
+    ret += 4 * p * (1 - p);
+  }
+  return ret;
+}
+
+void ActiveSampler::add(const Trial &trial)
+{
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      experiment_name_ = trial.input().experiment_name();
+      seen_.push_back({trial.sample(), complete.output().preds()});
+    },
+    [&](const TrialStatus &) {}));
+}
+
+void ActiveSampler::refit(io::yield_context yield)
+{
+  auto log = spdlog::get("log");
+
+  std::vector<Trial> trials;
+  trials.reserve(seen_.size());
+  for (const auto &seen : seen_) {
+    TrialOutput output;
+    output.preds() = seen.preds;
+    Trial trial(experiment_name_, seen.sample);
+    trial.status(TrialStatus::Complete::mk(std::move(output)));
+    trials.emplace_back(std::move(trial));
+  }
+
+  Analysis analyzer("LogisticRegression", std::move(trials));
+  try {
+    analyzer.run(yield);
+  } catch (const std::exception &e) {
+    log->warn("ActiveSampler::refit: keeping last fit, as fitting failed: "
+        "{}", e.what());
+    return;
+  }
+
+  size_t fit = 0;
+  analyzer.status().visit(xtd::overload(
+    [&](const AnalysisStatus::Complete &complete) {
+      complete.output().visit(xtd::overload(
+        [&](const AnalysisOutput::LogisticRegression &output) {
+          for (const auto &pred : preds_) {
+            auto i = output.preds().find(pred);
+            if (i != output.preds().end() && !i->second.coeffs().empty()) {
+              fits_[pred] = i->second.coeffs();
+              ++fit;
+            }
+          }
+        },
+        [&](const AnalysisOutput &) {}));
+    },
+    [&](const AnalysisStatus &) {}));
+
+  if (fit > 0) {
+    ++fit_count_;
+  }
+  SPDLOG_DEBUG(log, "ActiveSampler::refit: fit {} of {} predicates: {}",
+      fit, preds_.size(), xtd::lazy_json_dump(fits_));
+}
+
+std::vector<Trial> ActiveSampler::draw(const Experiment &exp, size_t n)
+{
+  std::vector<Trial> ret;
+  ret.reserve(n);
+
+  std::vector<TrialInput::sample_type> candidates(pool_);
+  std::vector<double> scores(pool_);
+  std::uniform_real_distribution<> unit;
+  for (size_t i = 0; i < n; ++i) {
+    double total = 0;
+    for (size_t j = 0; j < pool_; ++j) {
+      candidates[j] = exp.inputs().sample();
+      scores[j] = uncertainty(candidates[j]);
+      total += scores[j];
+    }
+
+    // Candidate j is picked with probability (explore + (1 - explore) *
+    // scores[j] / mean) / pool, so its likelihood ratio, against a sample
+    // drawn from the specs alone, is about the inverse of the first factor
+    size_t pick = 0;
+    if (total <= 0 || unit(random_) < explore_) {
+      pick = std::uniform_int_distribution<size_t>(0, pool_ - 1)(random_);
+    } else {
+      pick = std::discrete_distribution<size_t>(
+          scores.begin(), scores.end())(random_);
+    }
+    double weight = 1;
+    if (total > 0) {
+      double mean = total / pool_;
+      weight = 1 / (explore_ + (1 - explore_) * scores[pick] / mean);
+    }
+
+    Trial trial(exp.name(), std::move(candidates[pick]));
+    trial.input().weight(weight);
+    ret.emplace_back(std::move(trial));
+  }
+  return ret;
+}
+
+} // namespace royale
@@ -0,0 +1,207 @@
+#include <royale/Blob.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace royale {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// SHA-1 (FIPS 180-4), kept here so digests don't depend on any library's
+/// internals. Not for security: it only names blobs.
+class Sha1
+{
+private:
+  uint32_t h_[5] = {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+  unsigned char block_[64];
+  size_t used_ = 0;
+  uint64_t length_ = 0;
+
+  static uint32_t rotl(uint32_t x, int n)
+  {
+    return (x << n) | (x >> (32 - n));
+  }
+
+  void compress()
+  {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const unsigned char *p = block_ + 4 * i;
+      w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 |
+        uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+      uint32_t t = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = t;
+    }
+    h_[0] += a;
+    h_[1] += b;
+    h_[2] += c;
+    h_[3] += d;
+    h_[4] += e;
+    used_ = 0;
+  }
+
+public:
+  void update(const char *data, size_t size)
+  {
+    length_ += size;
+    for (size_t i = 0; i < size; ++i) {
+      block_[used_++] = static_cast<unsigned char>(data[i]);
+      if (used_ == 64) {
+        compress();
+      }
+    }
+  }
+
+  std::string hex()
+  {
+    uint64_t bits = length_ * 8;
+    block_[used_++] = 0x80;
+    if (used_ > 56) {
+      while (used_ < 64) {
+        block_[used_++] = 0;
+      }
+      compress();
+    }
+    while (used_ < 56) {
+      block_[used_++] = 0;
+    }
+    for (int i = 7; i >= 0; --i) {
+      block_[used_++] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    compress();
+
+    char hex[41];
+    for (int i = 0; i < 5; ++i) {
+      std::snprintf(hex + i * 8, 9, "%08x", static_cast<unsigned>(h_[i]));
+    }
+    return std::string(hex, 40);
+  }
+};
+
+} // namespace
+
+BlobStore *&BlobStore::default_ptr()
+{
+  static BlobStore *store = nullptr;
+  return store;
+}
+
+BlobStore::BlobStore(bfs::path dir) : dir_(std::move(dir))
+{
+  bfs::create_directories(dir_);
+}
+
+std::string BlobStore::digest(const std::string &text)
+{
+  Sha1 sha;
+  sha.update(text.data(), text.size());
+  return sha.hex();
+}
+
+std::string BlobStore::put(const std::string &text)
+{
+  std::string ret = digest(text);
+
+  if (dir_.empty()) {
+    blobs_.emplace(ret, text);
+    return ret;
+  }
+
+  if (known_.count(ret) > 0) {
+    return ret;
+  }
+  auto path = dir_ / ret;
+  if (!bfs::exists(path)) {
+    // Write under a temporary name first, so readers never see part of a blob
+    auto tmp = dir_ / (ret + ".tmp" + std::to_string(::getpid()));
+    {
+      std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+      out.write(text.data(), text.size());
+      if (!out) {
+        throw std::runtime_error("Couldn't write blob " + tmp.string());
+      }
+    }
+    bfs::rename(tmp, path);
+  }
+  known_.insert(ret);
+  return ret;
+}
+
+std::string BlobStore::get(const std::string &digest) const
+{
+  auto i = blobs_.find(digest);
+  if (i != blobs_.end()) {
+    return i->second;
+  }
+  if (!dir_.empty()) {
+    return xtd::file_to_string((dir_ / digest).c_str());
+  }
+  throw std::runtime_error("Blob " + digest + " not found");
+}
+
+const std::string &Blob::text() const
+{
+  if (!has_text_) {
+    auto store = BlobStore::default_store();
+    if (!store) {
+      throw std::runtime_error("Blob " + digest_ + " can't be loaded: no "
+          "blob store");
+    }
+    text_ = store->get(digest_);
+    has_text_ = true;
+  }
+  return text_;
+}
+
+void Blob::externalize(BlobStore &store, size_t min_size)
+{
+  if (digest_ != "") {
+    // Already out of line; make sure this store has it, too
+    if (has_text_) {
+      store.put(text_);
+    }
+  } else if (text_.size() >= min_size) {
+    digest_ = store.put(text_);
+  }
+}
+
+void Blob::internalize(const BlobStore &store)
+{
+  if (!has_text_) {
+    text_ = store.get(digest_);
+    has_text_ = true;
+  }
+  digest_.clear();
+}
+
+} // namespace royale
@@ -0,0 +1,112 @@
+#include <royale/Capture.hpp>
+
+#include <unistd.h>
+#include <atomic>
+#include <boost/filesystem.hpp>
+
+namespace royale {
+
+void StreamCapture::start_spill()
+{
+  static std::atomic<uint64_t> seq{0};
+
+  auto path = boost::filesystem::path(config_.spill_dir) /
+    ("royale-" + std::to_string(::getpid()) + "-" +
+     std::to_string(++seq) + "." + label_);
+
+  spill_ = std::make_unique<std::ofstream>(path.string(),
+      std::ios::binary | std::ios::trunc);
+  if (!spill_->is_open()) {
+    spdlog::get("log")->warn("Couldn't create spill file {}; dropping the "
+        "middle of {} instead", path.string(), label_);
+    spill_.reset();
+    config_.spill_dir.clear();
+    return;
+  }
+  spill_path_ = path.string();
+
+  // Nothing has been dropped yet, so this is the whole stream so far
+  std::string kept = str();
+  spill_->write(kept.data(), kept.size());
+}
+
+void StreamCapture::append(const char *data, size_t n)
+{
+  if (n == 0) {
+    return;
+  }
+  if (on_data_) {
+    on_data_(data, n);
+  }
+
+  if (!spill_ && config_.spill_dir != "" && config_.limit > 0 &&
+      total_ + n > config_.limit) {
+    start_spill();
+  }
+  if (spill_) {
+    spill_->write(data, n);
+  }
+  total_ += n;
+
+  if (config_.limit == 0) {
+    head_.append(data, n);
+    return;
+  }
+
+  size_t h = std::min(n, head_max() - head_.size());
+  head_.append(data, h);
+  data += h;
+  n -= h;
+
+  size_t max = tail_max();
+  if (n == 0 || max == 0) {
+    return;
+  }
+  if (n >= max) {
+    tail_.assign(data + (n - max), data + n);
+    tail_pos_ = 0;
+    return;
+  }
+  if (tail_.size() < max) {
+    size_t grow = std::min(n, max - tail_.size());
+    tail_.insert(tail_.end(), data, data + grow);
+    data += grow;
+    n -= grow;
+  }
+  while (n > 0) {
+    size_t chunk = std::min(n, max - tail_pos_);
+    std::copy(data, data + chunk, tail_.begin() + tail_pos_);
+    tail_pos_ = (tail_pos_ + chunk) % max;
+    data += chunk;
+    n -= chunk;
+  }
+}
+
+std::string StreamCapture::str() const
+{
+  std::string ret;
+  ret.reserve(head_.size() + tail_.size() + 64);
+  ret += head_;
+  if (truncated()) {
+    ret += "\n[... ";
+    ret += std::to_string(total_ - head_.size() - tail_.size());
+    ret += " bytes omitted ...]\n";
+  }
+  ret.append(tail_.begin() + tail_pos_, tail_.end());
+  ret.append(tail_.begin(), tail_.begin() + tail_pos_);
+  return ret;
+}
+
+std::string StreamCapture::take()
+{
+  std::string ret = str();
+  head_.clear();
+  tail_.clear();
+  tail_pos_ = 0;
+  total_ = 0;
+  spill_.reset();
+  spill_path_.clear();
+  return ret;
+}
+
+} // namespace royale
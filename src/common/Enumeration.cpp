@@ -0,0 +1,54 @@
+#include <royale/Enumeration.hpp>
+
+namespace royale {
+
+std::unique_ptr<InputEnumeration> InputEnumeration::of(const InputSpec &spec,
+    size_t max_size)
+{
+  auto ret = std::make_unique<InputEnumeration>();
+  for (const auto &input : spec.inputs()) {
+    ValueSpec::support_type support;
+    if (!input.second->finite_support(support)) {
+      return nullptr;
+    }
+    if (support.size() > max_size / ret->size_) {
+      return nullptr;
+    }
+    ret->size_ *= support.size();
+    ret->inputs_.emplace_back(input.first,
+        values_type(support.begin(), support.end()));
+  }
+  return ret;
+}
+
+std::pair<InputSpec::sample_type, double> InputEnumeration::at(size_t i) const
+{
+  std::pair<InputSpec::sample_type, double> ret;
+  ret.second = 1;
+  // Mixed radix: the last input varies fastest
+  for (auto input = inputs_.rbegin(); input != inputs_.rend(); ++input) {
+    const auto &values = input->second;
+    const auto &value = values[i % values.size()];
+    i /= values.size();
+    ret.first.emplace(input->first, value.first);
+    ret.second *= value.second;
+  }
+  return ret;
+}
+
+void EnumerationSummary::add(const Trial &trial)
+{
+  ++count_;
+  double weight = trial.input().weight() / size_;
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      for (const auto &pred : complete.output().preds()) {
+        preds_[pred.first].add(pred.second, weight);
+      }
+    },
+    [&](const TrialStatus &) {
+      ++error_count_;
+    }));
+}
+
+} // namespace royale
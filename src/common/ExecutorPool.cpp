@@ -0,0 +1,216 @@
+#include <royale/ExecutorPool.hpp>
+
+#include <chrono>
+#include <limits>
+#include <boost/asio.hpp>
+#include <boost/asio/spawn.hpp>
+
+namespace royale {
+
+PersistentExecutor::PersistentExecutor(io::io_context &ioc,
+    const Experiment &exp, const LaunchPlan &plan,
+    const CaptureConfig &capture)
+  : in_(ioc), out_(ioc), err_(std::make_shared<bp::async_pipe>(ioc)),
+    child_(plan.exe().string(),
+      bp::args(plan.args()),
+      bp::std_in < in_,
+      bp::std_out > out_,
+      bp::std_err > *err_,
+      plan.env_init(),
+      bp::start_dir(plan.start_dir().string()),
+      group_),
+    timer_(ioc),
+    out_buf_(capture.limit > 0 ? capture.limit :
+        std::numeric_limits<size_t>::max()),
+    stderr_(std::make_shared<StreamCapture>(capture, "stderr"))
+{
+  spdlog::get("log")->debug("Started persistent executor {} for \"{}\"",
+      child_.id(), exp.name());
+  // The pipe and capture outlive the executor if the read is still pending
+  async_capture(err_, stderr_, []() {});
+}
+
+PersistentExecutor::~PersistentExecutor()
+{
+  std::error_code ec;
+  boost::system::error_code bec;
+  in_.close(bec);
+  out_.close(bec);
+  err_->close(bec);
+  if (child_.running(ec)) {
+    child_.terminate(ec);
+  }
+}
+
+bool PersistentExecutor::run(Trial &trial, std::string &sout, double timeout,
+    io::yield_context yield)
+{
+  std::string line = json(trial.input()).dump();
+  line += '\n';
+
+  // The timer's handler may already be queued when this trial finishes, so
+  // it only touches this executor while the trial is still running
+  auto running = std::make_shared<bool>(true);
+  if (timeout > 0) {
+    timer_.expires_after(xtd::to_duration(timeout));
+    timer_.async_wait(
+      [this, running](const boost::system::error_code &ec) {
+        if (ec || !*running) {
+          return;
+        }
+        timed_out_ = true;
+        std::error_code gec;
+        group_.terminate(gec);
+      });
+  }
+  struct cancel_timer {
+    io::steady_timer &timer;
+    std::shared_ptr<bool> running;
+    ~cancel_timer() { *running = false; timer.cancel(); }
+  } cancel{timer_, running};
+
+  boost::system::error_code ec;
+  io::async_write(in_, io::buffer(line), yield[ec]);
+  if (ec) {
+    SPDLOG_DEBUG(spdlog::get("log"), "PersistentExecutor::run: write to {} "
+        "failed: {}", child_.id(), ec.message());
+    return false;
+  }
+
+  size_t n = io::async_read_until(out_, out_buf_, '\n', yield[ec]);
+  auto begin = io::buffers_begin(out_buf_.data());
+  if (ec == io::error::not_found) {
+    spdlog::get("log")->warn("Persistent executor {} wrote an output line "
+        "over the capture limit", child_.id());
+  }
+  if (ec) {
+    SPDLOG_DEBUG(spdlog::get("log"), "PersistentExecutor::run: read from {} "
+        "failed: {}", child_.id(), ec.message());
+    sout.assign(begin, io::buffers_end(out_buf_.data()));
+    return false;
+  }
+  sout.assign(begin, begin + (n - 1));
+  out_buf_.consume(n);
+
+  ++trials_;
+  return true;
+}
+
+std::string PersistentExecutor::take_stderr(Trial &trial)
+{
+  if (stderr_->spill_path() != "") {
+    trial.files()["stderr"] = stderr_->spill_path();
+  }
+  return stderr_->take();
+}
+
+void PersistentExecutor::retire()
+{
+  boost::system::error_code ec;
+  in_.close(ec);
+}
+
+int PersistentExecutor::reap(io::yield_context yield)
+{
+  // Poll, rather than block the io_context in a wait for the child
+  std::error_code ec;
+  boost::system::error_code tec;
+  for (int i = 0; i < 10 && child_.running(ec); ++i) {
+    timer_.expires_after(std::chrono::milliseconds(10));
+    timer_.async_wait(yield[tec]);
+  }
+  if (child_.running(ec)) {
+    child_.terminate(ec);
+  }
+  return child_.exit_code();
+}
+
+bool PersistentExecutor::exited()
+{
+  std::error_code ec;
+  return !child_.running(ec);
+}
+
+ExecutorPool::executor_ptr ExecutorPool::acquire()
+{
+  retiring_.remove_if([](const executor_ptr &e) { return e->exited(); });
+
+  if (idle_.size() > 0) {
+    auto ret = std::move(idle_.front());
+    idle_.pop_front();
+    return ret;
+  }
+  return std::make_unique<PersistentExecutor>(*ioc_, *exp_, plan_,
+      capture_);
+}
+
+void ExecutorPool::release(executor_ptr e)
+{
+  if (exp_->recycle() > 0 && e->trials() >= exp_->recycle()) {
+    SPDLOG_DEBUG(spdlog::get("log"), "Recycling executor {} for \"{}\" after "
+        "{} trials", e->pid(), exp_->name(), e->trials());
+    e->retire();
+    retiring_.emplace_back(std::move(e));
+  } else {
+    idle_.emplace_front(std::move(e));
+  }
+}
+
+Trial ExecutorPool::run(Trial trial, io::yield_context yield)
+{
+  auto log = spdlog::get("log");
+
+  for (int attempt = 0;; ++attempt) {
+    auto e = acquire();
+    bool fresh = e->trials() == 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::string sout;
+    if (!e->run(trial, sout, exp_->timeout(), yield)) {
+      int code = e->reap(yield);
+      std::string serr = e->take_stderr(trial);
+
+      if (e->timed_out()) {
+        log->warn("Persistent executor {} for \"{}\" timed out",
+            e->pid(), exp_->name());
+        trial.status(TrialStatus::Error::mk(ErrorKind::Timeout::mk(
+                xtd::seconds_since(start), std::move(sout), std::move(serr))));
+        return trial;
+      }
+
+      log->warn("Persistent executor {} for \"{}\" died with code {}",
+          e->pid(), exp_->name(), code);
+
+      // An executor that died while idle is restarted, and the trial retried
+      if (!fresh && sout.empty() && attempt == 0) {
+        continue;
+      }
+
+      trial.status(TrialStatus::Error::mk(ErrorKind::ExitStatus::mk(
+              code, std::move(sout), std::move(serr))));
+      return trial;
+    }
+
+    std::string serr = e->take_stderr(trial);
+
+    log->info("Persistent executor {} finished trial", e->pid());
+    log->info("  stdout: {}", xtd::lazy_json_dump(sout));
+    log->info("  stderr: {}", xtd::lazy_json_dump(serr));
+
+    try {
+      TrialOutput out = json::parse(sout);
+      out.check_aux();
+      trial.status(TrialStatus::Complete::mk(std::move(out), std::move(serr)));
+      release(std::move(e));
+    } catch (const std::exception &) {
+      // Can't trust the executor to stay in step with us after bad output
+      trial.status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
+              std::move(sout), std::move(serr))));
+      e->retire();
+      retiring_.emplace_back(std::move(e));
+    }
+    return trial;
+  }
+}
+
+} // namespace royale
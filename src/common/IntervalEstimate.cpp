@@ -0,0 +1,149 @@
+#include <royale/IntervalEstimate.hpp>
+
+#include <cmath>
+#include <boost/math/distributions/beta.hpp>
+#include <boost/math/distributions/normal.hpp>
+
+namespace royale {
+
+namespace {
+
+void check_confidence(double confidence)
+{
+  if (!(confidence > 0 && confidence < 1)) {
+    throw std::runtime_error("Confidence must be within (0, 1)");
+  }
+}
+
+} // namespace
+
+std::pair<double, double> wilson_interval(size_t sat, size_t n,
+    double confidence)
+{
+  check_confidence(confidence);
+  if (n == 0) {
+    return {0, 1};
+  }
+
+  double z = boost::math::quantile(boost::math::normal(),
+      1 - (1 - confidence) / 2);
+  double z2 = z * z;
+  double p = sat / (double)n;
+
+  double denom = 1 + z2 / n;
+  double center = (p + z2 / (2 * n)) / denom;
+  double half = z / denom * std::sqrt(p * (1 - p) / n + z2 / (4.0 * n * n));
+  return {std::max(center - half, 0.0), std::min(center + half, 1.0)};
+}
+
+std::pair<double, double> clopper_pearson_interval(size_t sat, size_t n,
+    double confidence)
+{
+  check_confidence(confidence);
+  if (n == 0) {
+    return {0, 1};
+  }
+
+  double tail = (1 - confidence) / 2;
+  double lower = 0;
+  double upper = 1;
+  if (sat > 0) {
+    lower = boost::math::quantile(
+        boost::math::beta_distribution<>(sat, n - sat + 1), tail);
+  }
+  if (sat < n) {
+    upper = boost::math::quantile(
+        boost::math::beta_distribution<>(sat + 1, n - sat), 1 - tail);
+  }
+  return {lower, upper};
+}
+
+std::pair<double, double> weighted_interval(double sum, double sum_sq,
+    size_t n, double confidence)
+{
+  check_confidence(confidence);
+  if (n < 2) {
+    return {0, 1};
+  }
+
+  double z = boost::math::quantile(boost::math::normal(),
+      1 - (1 - confidence) / 2);
+  double mean = sum / n;
+  double var = std::max(sum_sq - n * mean * mean, 0.0) / (n - 1);
+  double half = z * std::sqrt(var / n);
+  return {std::max(mean - half, 0.0), std::min(mean + half, 1.0)};
+}
+
+size_t okamoto_trials(double half_width, double confidence)
+{
+  check_confidence(confidence);
+  if (!(half_width > 0)) {
+    throw std::runtime_error("Interval half-width must be positive");
+  }
+  return std::ceil(std::log(2 / (1 - confidence)) /
+      (2 * half_width * half_width));
+}
+
+IntervalEstimate::IntervalEstimate(const std::vector<std::string> &preds,
+    double half_width, double confidence, std::string method)
+  : method_(std::move(method)), confidence_(confidence),
+    half_width_(half_width)
+{
+  if (preds.empty()) {
+    throw std::runtime_error("No predicates to estimate");
+  }
+  if (!(half_width_ > 0 && half_width_ <= 0.5)) {
+    throw std::runtime_error("Interval half-width must be within (0, 0.5]");
+  }
+  planned_ = okamoto_trials(half_width_, confidence_);
+
+  for (const auto &pred : preds) {
+    auto &output = preds_[pred];
+    output.name(pred);
+    // Validates method_
+    output.interval(method_, confidence_);
+  }
+}
+
+bool IntervalEstimate::done() const
+{
+  for (const auto &pred : preds_) {
+    const auto &output = pred.second;
+    if (output.count() == output.error_count() ||
+        output.half_width() > half_width_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IntervalEstimate::add(const Trial &trial)
+{
+  const TrialOutput *complete_output = nullptr;
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      complete_output = &complete.output();
+    },
+    [&](const TrialStatus &) {}));
+
+  for (auto &pred : preds_) {
+    auto &output = pred.second;
+    if (complete_output) {
+      const auto &preds = complete_output->preds();
+      auto i = preds.find(pred.first);
+      if (i != preds.end()) {
+        if (i->second) {
+          output.add_sat(trial.input().weight());
+        } else {
+          output.add_unsat(trial.input().weight());
+        }
+        output.interval(method_, confidence_);
+        continue;
+      }
+    }
+    output.add_error();
+  }
+  return done();
+}
+
+} // namespace royale
@@ -0,0 +1,101 @@
+#include <royale/Journal.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+
+namespace royale {
+
+Journal::Journal(std::string path, size_t group)
+  : path_(std::move(path)), group_(std::max(group, size_t(1))),
+    synced_at_(std::chrono::steady_clock::now())
+{
+  fd_ = ROYALE_ERRNO_THROW(::open,
+      (path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644));
+}
+
+Journal::~Journal()
+{
+  try {
+    sync();
+  } catch (const std::exception &e) {
+    spdlog::get("log")->error("Journal: failed to sync {}: {}", path_,
+        e.what());
+  }
+  ::close(fd_);
+}
+
+void Journal::append(const Trial &trial)
+{
+  std::string line = json(trial).dump();
+  line += '\n';
+
+  // O_APPEND keeps each line whole within the file, even across processes
+  const char *cur = line.data();
+  size_t left = line.size();
+  while (left > 0) {
+    ssize_t n = ::write(fd_, cur, left);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      xtd::errchk_throw("write", __FILE__, __LINE__);
+    }
+    cur += n;
+    left -= n;
+  }
+
+  ++unsynced_;
+  if (unsynced_ >= group_ ||
+      std::chrono::steady_clock::now() - synced_at_ >=
+        std::chrono::seconds(1)) {
+    sync();
+  }
+}
+
+void Journal::sync()
+{
+  if (unsynced_ == 0) {
+    return;
+  }
+  ROYALE_ERRNO_THROW(::fdatasync, (fd_));
+  unsynced_ = 0;
+  synced_at_ = std::chrono::steady_clock::now();
+}
+
+std::vector<Trial> Journal::load(const std::string &path)
+{
+  auto log = spdlog::get("log");
+
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Couldn't open journal " + path);
+  }
+
+  std::vector<Trial> ret;
+  std::string line;
+  std::streamoff good = 0;
+  size_t lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    bool complete = !in.eof();
+    try {
+      if (!complete) {
+        throw std::runtime_error("no newline");
+      }
+      ret.emplace_back(json::parse(line).get<Trial>());
+      good = in.tellg();
+    } catch (const std::exception &e) {
+      if (in.peek() != std::ifstream::traits_type::eof()) {
+        throw std::runtime_error("Bad journal " + path + " line " +
+            std::to_string(lineno) + ": " + e.what());
+      }
+      log->warn("Journal: dropping partly written last line of {}", path);
+      ROYALE_ERRNO_THROW(::truncate, (path.c_str(), good));
+    }
+  }
+  log->info("Journal: loaded {} trials from {}", ret.size(), path);
+  return ret;
+}
+
+} // namespace royale
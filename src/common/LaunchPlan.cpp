@@ -0,0 +1,95 @@
+#include <royale/LaunchPlan.hpp>
+
+#include <cstring>
+
+#include <boost/process.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+extern char **environ;
+
+namespace royale {
+
+namespace bp = boost::process;
+namespace bfs = boost::filesystem;
+
+LaunchPlan::LaunchPlan(const Experiment &exp)
+{
+  auto log = spdlog::get("log");
+
+  const auto &cmd = exp.cmd();
+  if (cmd.size() == 0) {
+    throw std::runtime_error("Experiment \"" + exp.name() + "\" has no cmd");
+  }
+
+  start_dir_ = bfs::absolute(exp.cd());
+
+  for (char **cur = environ; *cur; ++cur) {
+    const char *eq = std::strchr(*cur, '=');
+    if (eq) {
+      vars_[std::string(const_cast<const char *>(*cur), eq)] = eq + 1;
+    }
+  }
+  for (const auto &cur : exp.env()) {
+    vars_[cur.first] = cur.second;
+  }
+  build_envp();
+
+  if (cmd[0].find('/') != std::string::npos) {
+    exe_ = bfs::absolute(cmd[0], start_dir_);
+  } else {
+    std::vector<bfs::path> path;
+    auto env_path = vars_.find("PATH");
+    if (env_path != vars_.end()) {
+      std::vector<std::string> dirs;
+      boost::split(dirs, env_path->second, boost::is_any_of(":"));
+      path.assign(dirs.begin(), dirs.end());
+    }
+    path.push_back(start_dir_);
+
+    SPDLOG_DEBUG(log, "Search path: {}", xtd::lazy_json_dump(path));
+
+    exe_ = bp::search_path(cmd[0], std::move(path));
+  }
+
+  if (exe_.empty()) {
+    log->warn("Executable \"{}\" for experiment \"{}\" not found",
+        cmd[0], exp.name());
+  } else {
+    SPDLOG_DEBUG(log, "Search result: {}", xtd::lazy_json_dump(exe_));
+  }
+
+  args_.assign(cmd.begin() + 1, cmd.end());
+}
+
+LaunchPlan LaunchPlan::with_env(const env_type &extra) const
+{
+  LaunchPlan ret;
+  ret.exe_ = exe_;
+  ret.args_ = args_;
+  ret.start_dir_ = start_dir_;
+  ret.vars_ = vars_;
+  for (const auto &cur : extra) {
+    ret.vars_[cur.first] = cur.second;
+  }
+  ret.build_envp();
+  return ret;
+}
+
+void LaunchPlan::build_envp()
+{
+  env_.clear();
+  env_.reserve(vars_.size());
+  for (const auto &cur : vars_) {
+    env_.emplace_back(cur.first + "=" + cur.second);
+  }
+
+  envp_.clear();
+  envp_.reserve(env_.size() + 1);
+  for (auto &cur : env_) {
+    envp_.emplace_back(&cur[0]);
+  }
+  envp_.emplace_back(nullptr);
+}
+
+} // namespace royale
@@ -26,10 +26,10 @@ AnalysisOutput::Enum AnalysisType::LogisticRegression::do_analysis(
           auto &cur = preds[pred.first];
           if (pred.second) {
             SPDLOG_TRACE(log, "Predicate {} is sat", pred.first);
-            cur.add_sat();
+            cur.add_sat(trial.input().weight());
           } else {
             SPDLOG_TRACE(log, "Predicate {} is unsat", pred.first);
-            cur.add_unsat();
+            cur.add_unsat(trial.input().weight());
           }
         }
       },
@@ -80,6 +80,9 @@ AnalysisOutput::Enum AnalysisType::LogisticRegression::do_analysis(
       pred.second.coeffs(std::move(lpo_coeffs));
     }
   }
+  for (auto &pred : preds) {
+    pred.second.interval("wilson", 0.95);
+  }
   return output_type::mk(std::move(preds));
 }
 
@@ -0,0 +1,89 @@
+#include <royale/MemFd.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace royale {
+
+MappedFile::MappedFile(int fd)
+{
+  struct stat st;
+  ROYALE_ERRNO_THROW(::fstat, (fd, &st));
+  size_ = st.st_size;
+  if (size_ == 0) {
+    return;
+  }
+  void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    xtd::errchk_throw("mmap", __FILE__, __LINE__);
+  }
+  data_ = static_cast<const char *>(addr);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept
+{
+  std::swap(data_, o.data_);
+  std::swap(size_, o.size_);
+  return *this;
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+MemFd::MemFd(const char *name)
+{
+  fd_ = ROYALE_ERRNO_THROW(::memfd_create,
+      (name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+}
+
+MemFd &MemFd::operator=(MemFd &&o) noexcept
+{
+  std::swap(fd_, o.fd_);
+  return *this;
+}
+
+MemFd::~MemFd()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+MemFd &MemFd::write(const std::string &data)
+{
+  const char *cur = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = ::write(fd_, cur, left);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      xtd::errchk_throw("write", __FILE__, __LINE__);
+    }
+    cur += n;
+    left -= n;
+  }
+  return *this;
+}
+
+MemFd &MemFd::seal()
+{
+  ROYALE_ERRNO_THROW(::fcntl, (fd_, F_ADD_SEALS,
+        F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL));
+  ROYALE_ERRNO_THROW(::lseek, (fd_, 0, SEEK_SET));
+  return *this;
+}
+
+void MemFd::inherit() const
+{
+  ::fcntl(fd_, F_SETFD, 0);
+}
+
+} // namespace royale
@@ -0,0 +1,129 @@
+#include <royale/MemoCache.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <tuple>
+#include <unistd.h>
+#include "royale/Blob.hpp"
+
+namespace royale {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const char entry_extension[] = ".json";
+
+} // namespace
+
+MemoCache::MemoCache(bfs::path dir, uint64_t max_bytes)
+  : dir_(std::move(dir)), max_bytes_(max_bytes)
+{
+  bfs::create_directories(dir_);
+
+  std::vector<std::tuple<std::time_t, std::string, uint64_t>> found;
+  for (const auto &file : bfs::directory_iterator(dir_)) {
+    const auto &path = file.path();
+    if (path.extension() != entry_extension ||
+        !bfs::is_regular_file(path)) {
+      continue;
+    }
+    found.emplace_back(bfs::last_write_time(path), path.stem().string(),
+        bfs::file_size(path));
+  }
+  // Most recently used at the front
+  std::sort(found.begin(), found.end(),
+      [](const auto &a, const auto &b) {
+        return std::get<0>(a) > std::get<0>(b);
+      });
+  for (auto &entry : found) {
+    lru_.push_back(std::get<1>(entry));
+    entries_[std::get<1>(entry)] = {std::prev(lru_.end()), std::get<2>(entry)};
+    bytes_ += std::get<2>(entry);
+  }
+  evict();
+
+  spdlog::get("log")->info("MemoCache: {} entries ({} bytes) in {}",
+      entries_.size(), bytes_, dir_.string());
+}
+
+std::string MemoCache::key(const Experiment &exp, const TrialInput &input)
+{
+  // Objects dump with sorted keys, so equal samples give equal keys
+  json j = {exp.name(), exp.version(), input.sample(), input.replicate()};
+  return BlobStore::digest(j.dump());
+}
+
+bool MemoCache::get(const std::string &key, TrialStatus::Enum &status)
+{
+  auto i = entries_.find(key);
+  if (i == entries_.end()) {
+    stats_.add_lookup(false);
+    return false;
+  }
+
+  auto path = dir_ / (key + entry_extension);
+  try {
+    status = json::parse(xtd::file_to_string(path.c_str()));
+  } catch (const std::exception &e) {
+    // Removed or damaged behind our back; treat as a miss
+    SPDLOG_DEBUG(spdlog::get("log"), "MemoCache: dropping entry {}: {}",
+        key, e.what());
+    bfs::remove(path);
+    bytes_ -= i->second.size;
+    lru_.erase(i->second.pos);
+    entries_.erase(i);
+    stats_.add_lookup(false);
+    return false;
+  }
+
+  lru_.splice(lru_.begin(), lru_, i->second.pos);
+  boost::system::error_code ec;
+  bfs::last_write_time(path, std::time(nullptr), ec);
+  stats_.add_lookup(true);
+  return true;
+}
+
+void MemoCache::put(const std::string &key, const TrialStatus::Enum &status)
+{
+  std::string text = json(status).dump();
+
+  // Write under a temporary name first, so readers never see part of an
+  // entry
+  auto path = dir_ / (key + entry_extension);
+  auto tmp = dir_ / (key + ".tmp" + std::to_string(::getpid()));
+  {
+    std::ofstream out(tmp.string(), std::ios::binary | std::ios::trunc);
+    out.write(text.data(), text.size());
+    if (!out) {
+      throw std::runtime_error("Couldn't write memo entry " + tmp.string());
+    }
+  }
+  bfs::rename(tmp, path);
+
+  auto i = entries_.find(key);
+  if (i != entries_.end()) {
+    bytes_ -= i->second.size;
+    lru_.erase(i->second.pos);
+  }
+  lru_.push_front(key);
+  entries_[key] = {lru_.begin(), text.size()};
+  bytes_ += text.size();
+  evict();
+}
+
+void MemoCache::evict()
+{
+  while (bytes_ > max_bytes_ && !lru_.empty()) {
+    const std::string &key = lru_.back();
+    boost::system::error_code ec;
+    bfs::remove(dir_ / (key + entry_extension), ec);
+    auto i = entries_.find(key);
+    bytes_ -= i->second.size;
+    entries_.erase(i);
+    lru_.pop_back();
+    stats_.add_eviction();
+  }
+}
+
+} // namespace royale
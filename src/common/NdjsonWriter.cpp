@@ -0,0 +1,63 @@
+#include <royale/NdjsonWriter.hpp>
+
+namespace royale {
+
+NdjsonWriter::NdjsonWriter(io::io_context &ioc, std::ostream &out,
+    size_t buffer_size, std::chrono::milliseconds delay)
+  : out_(out), max_(buffer_size), delay_(delay), timer_(ioc)
+{
+  buf_.reserve(max_);
+}
+
+NdjsonWriter::~NdjsonWriter()
+{
+  *alive_ = false;
+  timer_.cancel();
+  try {
+    flush();
+  } catch (const std::exception &e) {
+    SPDLOG_DEBUG(spdlog::get("log"), "NdjsonWriter: final flush failed: {}",
+        e.what());
+  }
+}
+
+void NdjsonWriter::write(const json &j)
+{
+  buf_ += j.dump();
+  buf_ += '\n';
+
+  if (buf_.size() >= max_) {
+    flush();
+    return;
+  }
+
+  if (!armed_) {
+    armed_ = true;
+    timer_.expires_after(delay_);
+    // The handler may already be queued when this writer is destroyed, so
+    // it only touches the writer while it's alive
+    timer_.async_wait(
+      [this, alive = alive_](const boost::system::error_code &ec) {
+        if (ec || !*alive) {
+          return;
+        }
+        armed_ = false;
+        flush();
+      });
+  }
+}
+
+void NdjsonWriter::flush()
+{
+  if (buf_.empty()) {
+    return;
+  }
+  out_.write(buf_.data(), buf_.size());
+  out_.flush();
+  buf_.clear();
+  if (!out_) {
+    throw std::runtime_error("NdjsonWriter: failed to write output");
+  }
+}
+
+} // namespace royale
@@ -0,0 +1,97 @@
+#include <royale/PluginPool.hpp>
+
+#include <dlfcn.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <boost/filesystem.hpp>
+
+namespace royale {
+
+namespace bfs = boost::filesystem;
+
+Plugin::Plugin(std::string path) : path_(std::move(path))
+{
+  // Never closed: a plugin may leave behind threads or thread_local
+  // destructors which would crash if it were unloaded
+  void *lib = ::dlopen(path_.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!lib) {
+    throw std::runtime_error("Couldn't load plugin " + path_ + ": " +
+        ::dlerror());
+  }
+  run_ = reinterpret_cast<royale_run_fn>(::dlsym(lib, "royale_run"));
+  if (!run_) {
+    throw std::runtime_error("Plugin " + path_ + " has no royale_run");
+  }
+}
+
+std::string Plugin::resolve(const Experiment &exp)
+{
+  if (exp.plugin().find('/') == std::string::npos) {
+    return exp.plugin();
+  }
+  return bfs::absolute(exp.plugin(), bfs::absolute(exp.cd())).string();
+}
+
+std::pair<int, std::string> Plugin::run(const std::string &input) const
+{
+  std::pair<int, std::string> ret;
+  ret.first = run_(input.data(), input.size(),
+      [](void *ctx, const char *data, size_t len) {
+        static_cast<std::string *>(ctx)->append(data, len);
+      }, &ret.second);
+  return ret;
+}
+
+int Plugin::host(const std::string &path)
+{
+  Plugin plugin(path);
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    auto result = plugin.run(line);
+    if (result.first != 0) {
+      std::cout << result.second << std::flush;
+      return result.first;
+    }
+
+    // Valid JSON has no raw newlines except as whitespace, so this keeps the
+    // output on one line without reparsing it
+    std::replace(result.second.begin(), result.second.end(), '\n', ' ');
+    std::cout << result.second << '\n' << std::flush;
+  }
+  return 0;
+}
+
+PluginPool::PluginPool(io::io_context &ioc, const Experiment &exp,
+    size_t threads)
+  : ioc_(&ioc), plugin_(Plugin::resolve(exp)), threads_(threads)
+{
+  SPDLOG_DEBUG(spdlog::get("log"), "Loaded plugin {} for \"{}\" on {} "
+      "threads", plugin_.path(), exp.name(), threads);
+}
+
+PluginPool::~PluginPool()
+{
+  threads_.join();
+}
+
+void PluginPool::run(std::string input, handler_type handler)
+{
+  // Keep the runner's io_context running until the result is back
+  auto work = io::make_work_guard(*ioc_);
+  io::post(threads_,
+    [this, input = std::move(input), handler = std::move(handler),
+      work = std::move(work)]() mutable {
+      auto start = std::chrono::steady_clock::now();
+      auto result = plugin_.run(input);
+      double elapsed = xtd::seconds_since(start);
+      io::post(*ioc_,
+        [handler = std::move(handler), result = std::move(result), elapsed]
+        () mutable {
+          handler(result.first, std::move(result.second), elapsed);
+        });
+    });
+}
+
+} // namespace royale
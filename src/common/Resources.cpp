@@ -0,0 +1,326 @@
+#include <royale/Resources.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+namespace royale {
+
+namespace bfs = boost::filesystem;
+
+CpuSet parse_cpu_list(const std::string &list)
+{
+  CpuSet ret;
+
+  std::vector<std::string> ranges;
+  boost::split(ranges, list, boost::is_any_of(", \n"),
+      boost::token_compress_on);
+  for (const auto &range : ranges) {
+    if (range.empty()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first :
+        std::stoi(range.substr(dash + 1));
+      for (int i = first; i <= last; ++i) {
+        ret.insert(i);
+      }
+    } catch (const std::logic_error &) {
+      throw std::runtime_error("Bad CPU list \"" + list + "\"");
+    }
+  }
+  return ret;
+}
+
+std::string format_cpu_list(const CpuSet &cpus)
+{
+  std::ostringstream ret;
+  for (auto i = cpus.begin(); i != cpus.end();) {
+    int first = *i;
+    int last = first;
+    while (++i != cpus.end() && *i == last + 1) {
+      ++last;
+    }
+    if (ret.tellp() > 0) {
+      ret << ',';
+    }
+    ret << first;
+    if (last != first) {
+      ret << '-' << last;
+    }
+  }
+  return ret.str();
+}
+
+namespace {
+
+CpuSet affinity_cpus()
+{
+  CpuSet ret;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  ROYALE_ERRNO_THROW(::sched_getaffinity, (0, sizeof(mask), &mask));
+  for (int i = 0; i < CPU_SETSIZE; ++i) {
+    if (CPU_ISSET(i, &mask)) {
+      ret.insert(i);
+    }
+  }
+  return ret;
+}
+
+std::vector<CpuSet> numa_nodes()
+{
+  auto log = spdlog::get("log");
+
+  CpuSet usable = affinity_cpus();
+  std::vector<CpuSet> ret;
+
+  bfs::path sys("/sys/devices/system/node");
+  boost::system::error_code ec;
+  for (bfs::directory_iterator i(sys, ec), end; !ec && i != end;
+      i.increment(ec)) {
+    auto name = i->path().filename().string();
+    if (name.compare(0, 4, "node") != 0 ||
+        !bfs::exists(i->path() / "cpulist")) {
+      continue;
+    }
+    CpuSet node;
+    for (int cpu : parse_cpu_list(
+          xtd::file_to_string((i->path() / "cpulist").c_str()))) {
+      if (usable.count(cpu) > 0) {
+        node.insert(cpu);
+      }
+    }
+    if (!node.empty()) {
+      SPDLOG_DEBUG(log, "NUMA {}: CPUs {}", name, format_cpu_list(node));
+      ret.emplace_back(std::move(node));
+    }
+  }
+
+  if (ret.empty()) {
+    ret.emplace_back(std::move(usable));
+  }
+  return ret;
+}
+
+void write_file(const bfs::path &path, const std::string &value)
+{
+  int fd = ROYALE_ERRNO_THROW(::open, (path.c_str(), O_WRONLY | O_CLOEXEC));
+  ssize_t n = ::write(fd, value.data(), value.size());
+  int err = errno;
+  ::close(fd);
+  if (n < 0) {
+    errno = err;
+    xtd::errchk_throw("write", __FILE__, __LINE__);
+  }
+}
+
+} // namespace
+
+CpuAllocator::CpuAllocator() : CpuAllocator(numa_nodes()) {}
+
+CpuAllocator::CpuAllocator(std::vector<CpuSet> nodes)
+  : nodes_(std::move(nodes)), free_(nodes_) {}
+
+CpuSet CpuAllocator::acquire(size_t n, const CpuSet &allowed)
+{
+  std::vector<CpuSet> avail;
+  avail.reserve(free_.size());
+  for (const auto &node : free_) {
+    if (allowed.empty()) {
+      avail.emplace_back(node);
+    } else {
+      avail.emplace_back();
+      std::set_intersection(node.begin(), node.end(),
+          allowed.begin(), allowed.end(),
+          std::inserter(avail.back(), avail.back().end()));
+    }
+  }
+
+  std::vector<size_t> order(avail.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  auto fits = std::find_if(order.begin(), order.end(),
+      [&](size_t i) { return avail[i].size() >= n; });
+
+  if (fits != order.end()) {
+    // Best fit: the fullest node that still has room
+    for (auto i = fits; i != order.end(); ++i) {
+      if (avail[*i].size() >= n && avail[*i].size() < avail[*fits].size()) {
+        fits = i;
+      }
+    }
+    order = { *fits };
+  } else {
+    std::stable_sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return avail[a].size() > avail[b].size(); });
+  }
+
+  CpuSet ret;
+  for (size_t node : order) {
+    for (int cpu : avail[node]) {
+      if (ret.size() >= n) {
+        break;
+      }
+      ret.insert(cpu);
+    }
+  }
+
+  if (ret.size() < n) {
+    return {};
+  }
+
+  for (auto &node : free_) {
+    for (int cpu : ret) {
+      node.erase(cpu);
+    }
+  }
+  return ret;
+}
+
+void CpuAllocator::release(const CpuSet &cpus)
+{
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    for (int cpu : cpus) {
+      if (nodes_[i].count(cpu) > 0) {
+        free_[i].insert(cpu);
+      }
+    }
+  }
+}
+
+CgroupLeaf::CgroupLeaf(const bfs::path &root, const std::string &name,
+    const Experiment &exp, const CpuSet &cpus)
+  : path_(root / name), procs_((path_ / "cgroup.procs").string())
+{
+  bfs::create_directory(path_);
+
+  try {
+    if (!cpus.empty()) {
+      write_file(path_ / "cpuset.cpus", format_cpu_list(cpus));
+    }
+    if (exp.memory_max() > 0) {
+      write_file(path_ / "memory.max", std::to_string(exp.memory_max()));
+      // Otherwise the limit is only reached once swap is full, too
+      boost::system::error_code ec;
+      if (bfs::exists(path_ / "memory.swap.max", ec)) {
+        write_file(path_ / "memory.swap.max", "0");
+      }
+    }
+    if (exp.cpu_weight() > 0) {
+      write_file(path_ / "cpu.weight", std::to_string(exp.cpu_weight()));
+    }
+  } catch (...) {
+    ::rmdir(path_.c_str());
+    throw;
+  }
+}
+
+CgroupLeaf::~CgroupLeaf()
+{
+  if (::rmdir(path_.c_str()) < 0) {
+    spdlog::get("log")->warn("Couldn't remove cgroup {}: {}",
+        path_.string(), std::strerror(errno));
+  }
+}
+
+bool CgroupLeaf::oom_killed() const
+{
+  try {
+    std::istringstream events(
+        xtd::file_to_string((path_ / "memory.events").c_str()));
+    std::string key;
+    uint64_t count;
+    while (events >> key >> count) {
+      if (key == "oom_kill" && count > 0) {
+        return true;
+      }
+    }
+  } catch (const std::exception &e) {
+    spdlog::get("log")->warn("Couldn't read memory.events of cgroup {}: {}",
+        path_.string(), e.what());
+  }
+  return false;
+}
+
+void CgroupLeaf::enable_controllers(const bfs::path &root)
+{
+  for (const char *ctrl : { "+cpu", "+cpuset", "+memory" }) {
+    try {
+      write_file(root / "cgroup.subtree_control", ctrl);
+    } catch (const std::exception &e) {
+      spdlog::get("log")->warn("Couldn't enable {} controller in cgroup {}: {}",
+          ctrl + 1, root.string(), e.what());
+    }
+  }
+}
+
+TrialResources::TrialResources(CpuAllocator &alloc,
+    const std::string &cgroup_root, const std::string &name,
+    const Experiment &exp)
+{
+  cpus_ = parse_cpu_list(exp.cpuset());
+
+  if (exp.cpus() > 0) {
+    owned_ = alloc.acquire(exp.cpus(), cpus_);
+    if (owned_.empty()) {
+      spdlog::get("log")->warn("Not enough free CPUs to pin trial of \"{}\" "
+          "to {}", exp.name(), exp.cpus());
+    } else {
+      alloc_ = &alloc;
+      cpus_ = owned_;
+    }
+  }
+
+  CPU_ZERO(&mask_);
+  for (int cpu : cpus_) {
+    CPU_SET(cpu, &mask_);
+  }
+
+  if (cgroup_root != "") {
+    try {
+      cgroup_ = std::make_unique<CgroupLeaf>(cgroup_root, name, exp, cpus_);
+    } catch (...) {
+      if (alloc_) {
+        alloc_->release(owned_);
+      }
+      throw;
+    }
+  }
+}
+
+TrialResources::~TrialResources()
+{
+  if (alloc_) {
+    alloc_->release(owned_);
+  }
+}
+
+void TrialResources::apply() const
+{
+  if (!cpus_.empty()) {
+    ::sched_setaffinity(0, sizeof(mask_), &mask_);
+  }
+  if (cgroup_) {
+    int fd = ::open(cgroup_->procs(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      (void)!::write(fd, "0", 1);
+      ::close(fd);
+    }
+  }
+}
+
+bool TrialResources::wanted(const Experiment &exp)
+{
+  return exp.cpuset() != "" || exp.cpus() > 0 || exp.memory_max() > 0 ||
+    exp.cpu_weight() > 0;
+}
+
+} // namespace royale
@@ -1,6 +1,8 @@
 #include <royale/Runner.hpp>
 
+#include <unistd.h>
 #include <boost/process.hpp>
+#include <boost/process/extend.hpp>
 #include <boost/beast/core/buffers_to_string.hpp>
 #include <boost/range/iterator_range.hpp>
 #include <boost/asio.hpp>
@@ -8,6 +10,8 @@
 
 namespace royale {
 
+namespace bfs = boost::filesystem;
+
 Experiment &Runner::add_experiment(Experiment e)
 {
   auto log = spdlog::get("log");
@@ -21,14 +25,79 @@ Experiment &Runner::add_experiment(Experiment e)
     throw std::runtime_error("Can't add experiment without name");
   }
 
-  auto ret = experiments_.emplace(std::piecewise_construct,
-      std::forward_as_tuple(std::move(name)),
-      std::forward_as_tuple(std::make_unique<Experiment>(std::move(e))));
+  if (e.protocol() != "spawn" && e.protocol() != "persistent" &&
+      e.protocol() != "zygote") {
+    throw std::runtime_error("Experiment \"" + name +
+        "\" has unknown protocol \"" + e.protocol() + "\"");
+  }
+
+  // The memo cache can't tell an edited executor from the old one, so
+  // cached trials are keyed by version, which must be given
+  if (e.deterministic() && e.version().empty()) {
+    throw std::runtime_error("Deterministic experiment \"" + name +
+        "\" needs a version, to change whenever its executor does");
+  }
+
+  if (e.transport() != "pipe" && e.transport() != "memfd") {
+    throw std::runtime_error("Experiment \"" + name +
+        "\" has unknown transport \"" + e.transport() + "\"");
+  }
 
-  if (!ret.second) {
+  if (e.transport() != "pipe" && e.protocol() != "spawn") {
+    log->warn("Experiment \"{}\": transport only applies to the spawn "
+        "protocol", name);
+  }
+
+  if (TrialResources::wanted(e)) {
+    if (e.protocol() != "spawn") {
+      log->warn("Experiment \"{}\": resource hints only apply to the spawn "
+          "protocol", name);
+    } else if (cgroup == "" && (e.memory_max() > 0 || e.cpu_weight() > 0)) {
+      log->warn("Experiment \"{}\": memory_max and cpu_weight need --cgroup",
+          name);
+    }
+  }
+
+  if (experiments_.count(name) > 0) {
     throw std::runtime_error("Experiment already added");
   }
 
+  for (const auto &p : e.proposal()) {
+    if (e.inputs().inputs().count(p.first) == 0) {
+      throw std::runtime_error("Experiment \"" + name + "\" has a proposal "
+          "for \"" + p.first + "\", which isn't one of its inputs");
+    }
+  }
+
+  if (e.batch_size() > 1 && (e.protocol() != "spawn" || e.plugin() != "")) {
+    log->warn("Experiment \"{}\": batch_size only applies to the spawn "
+        "protocol", name);
+  }
+
+  if (e.plugin() != "" && !e.isolate() && e.timeout() > 0) {
+    log->warn("Experiment \"{}\": timeout needs isolate for plugins", name);
+  }
+
+  if (e.plugin() != "") {
+    if (e.isolate()) {
+      // Isolated plugins are hosted by persistent executors running this
+      // program
+      Experiment host;
+      host.name(name)
+          .cd(e.cd())
+          .env(e.env())
+          .cmd({bfs::read_symlink("/proc/self/exe").string(),
+              "--plugin-host", Plugin::resolve(e)});
+      plans_.emplace(name, LaunchPlan(host));
+    }
+  } else {
+    plans_.emplace(name, LaunchPlan(e));
+  }
+
+  auto ret = experiments_.emplace(std::piecewise_construct,
+      std::forward_as_tuple(name),
+      std::forward_as_tuple(std::make_unique<Experiment>(std::move(e))));
+
   return *ret.first->second;
 }
 
@@ -83,12 +152,30 @@ Trial Runner::exec_remote_experiment(stream_type &stream, const Experiment &,
   return trial;
 }
 
-Trial Runner::run_trial(const std::string &name,
-    io::yield_context yield, stream_type *stream)
+Trial Runner::new_trial(const std::string &name)
 {
   auto log = spdlog::get("log");
 
-  log->info("Runner::run_trial: running \"{}\"", name);
+  auto pending = pending_.find(name);
+  if (pending != pending_.end() && !pending->second.empty()) {
+    Trial trial = std::move(pending->second.front());
+    pending->second.pop_front();
+    SPDLOG_DEBUG(log, "   Experiment \"{}\" pending inputs: {}",
+        name, xtd::lazy_json_dump(trial.sample()));
+    return trial;
+  }
+
+  auto enumerating = enumerations_.find(name);
+  if (enumerating != enumerations_.end()) {
+    const auto &cur = enumerating->second;
+    size_t n = drawn_[name]++;
+    auto sample = cur.space->at(cur.shard + n % cur.points * cur.shards);
+    Trial trial(name, std::move(sample.first));
+    trial.input().seq(n).weight(sample.second * cur.space->size());
+    SPDLOG_DEBUG(log, "   Experiment \"{}\" enumerated inputs: {}",
+        name, xtd::lazy_json_dump(trial.sample()));
+    return trial;
+  }
 
   Trial trial;
 
@@ -98,24 +185,259 @@ Trial Runner::run_trial(const std::string &name,
   SPDLOG_DEBUG(log, "   Experiment \"{}\": {}", name, xtd::lazy_json_dump(e));
 
   const auto &inputs = e.inputs();
+  if (!e.proposal().empty()) {
+    auto sample = inputs.sample(e.proposal());
+    SPDLOG_DEBUG(log, "   Experiment \"{}\" inputs: {} (weight {})",
+        name, xtd::lazy_json_dump(sample.first), sample.second);
+    trial.input().sample(std::move(sample.first));
+    trial.input().weight(sample.second);
+    trial.input().seq(drawn_[name]++);
+    return trial;
+  }
+
   auto sample = inputs.sample();
   SPDLOG_DEBUG(log, "   Experiment \"{}\" inputs: {}",
       name, xtd::lazy_json_dump(sample));
 
   trial.input().sample(std::move(sample));
+  trial.input().seq(drawn_[name]++);
+  return trial;
+}
+
+size_t Runner::enumerate(const std::string &name,
+    std::shared_ptr<InputEnumeration> space, size_t shard, size_t shards)
+{
+  if (shards == 0 || shard >= shards) {
+    throw std::runtime_error("Bad enumeration shard " +
+        std::to_string(shard) + " of " + std::to_string(shards));
+  }
+  size_t points = shard < space->size() ?
+    (space->size() - shard + shards - 1) / shards : 0;
+  spdlog::get("log")->info("Runner::enumerate: \"{}\" has {} input samples, "
+      "{} in shard {} of {}", name, space->size(), points, shard, shards);
+  if (points > 0) {
+    enumerations_[name] = {std::move(space), shard, shards, points};
+  }
+  return points;
+}
+
+size_t Runner::resume(const std::string &name, const std::set<size_t> &done)
+{
+  auto log = spdlog::get("log");
+
+  const auto &e = *experiments().at(name);
+  size_t &drawn = drawn_[name];
+  auto &pending = pending_[name];
+  size_t end = done.empty() ? 0 : *done.rbegin() + 1;
+  for (; drawn < end; ++drawn) {
+    std::pair<InputSpec::sample_type, double> sample;
+    if (e.proposal().empty()) {
+      sample = {e.inputs().sample(), 1};
+    } else {
+      sample = e.inputs().sample(e.proposal());
+    }
+    if (done.count(drawn) == 0) {
+      Trial trial(name, std::move(sample.first));
+      trial.input().seq(drawn).weight(sample.second);
+      pending.emplace_back(std::move(trial));
+    }
+  }
+  log->info("Runner::resume: \"{}\" continues from sample {}, with {} "
+      "incomplete trials to run again", name, drawn, pending.size());
+  return pending.size();
+}
+
+void Runner::queue(const std::string &name, std::vector<Trial> trials)
+{
+  size_t &drawn = drawn_[name];
+  auto &pending = pending_[name];
+  for (auto &trial : trials) {
+    trial.input().seq(drawn++);
+    pending.emplace_back(std::move(trial));
+  }
+}
+
+Trial Runner::run_trial(const std::string &name,
+    io::yield_context yield, stream_type *stream)
+{
+  return run_trial(new_trial(name), yield, stream);
+}
+
+Trial Runner::run_trial(Trial trial, io::yield_context yield,
+    stream_type *stream)
+{
+  auto log = spdlog::get("log");
+  const std::string &name = trial.input().experiment_name();
+
+  log->info("Runner::run_trial: running \"{}\"", name);
+
+  const auto &e = *experiments().at(name);
 
   if (stream) {
     return exec_remote_experiment(*stream, e, std::move(trial), yield);
   } else if (remote()) {
     return exec_remote_experiment(*remote(), e, std::move(trial), yield);
   } else {
+    if (recall(e, trial)) {
+      return trial;
+    }
     SPDLOG_TRACE(log, "Runner::run_trial: queueing experiment");
+    if (speculate > 0 && e.protocol() == "spawn" && e.plugin() == "") {
+      auto ret = race_trial(e, std::move(trial), yield);
+      remember(e, ret);
+      return ret;
+    }
     auto ret = exec_experiment(e, std::move(trial), yield);
     SPDLOG_TRACE(log, "Runner::run_trial: enqueued experiment");
+    remember(e, ret);
     return ret;
   }
 }
 
+bool Runner::recall(const Experiment &exp, Trial &trial)
+{
+  if (!memo || !exp.deterministic()) {
+    return false;
+  }
+  TrialStatus::Enum status;
+  if (!memo->get(MemoCache::key(exp, trial.input()), status)) {
+    return false;
+  }
+  SPDLOG_DEBUG(spdlog::get("log"), "Runner::recall: \"{}\" trial found in "
+      "memo cache", exp.name());
+  trial.status(std::move(status));
+  return true;
+}
+
+void Runner::remember(const Experiment &exp, const Trial &trial)
+{
+  if (!memo || !exp.deterministic()) {
+    return;
+  }
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &) {
+      try {
+        memo->put(MemoCache::key(exp, trial.input()), trial.status());
+      } catch (const std::exception &e) {
+        spdlog::get("log")->warn("Runner::remember: couldn't cache \"{}\" "
+            "trial: {}", exp.name(), e.what());
+      }
+    },
+    [](const TrialStatus &) {
+      // Failures may be down to the machine, not the input; run them again
+    }));
+}
+
+/// Fraction of Experiment::timeout given to executors as a soft deadline
+static const double soft_deadline_fraction = 0.9;
+
+/// Seconds to keep reading an executor's output after it exits
+static const double output_grace = 1.0;
+
+/// Set the final status of a trial from its executor's exit status and output.
+/// An error code of std::errc::timed_out means the executor was killed after
+/// running for @a elapsed seconds. If @a parser is given, it has been fed the
+/// whole of stdout, and its output is used instead of parsing @a sout.
+static void complete_trial(Trial &trial, int result, const std::error_code &ec,
+    double elapsed, std::string sout, std::string serr,
+    TrialOutputParser *parser = nullptr)
+{
+  auto log = spdlog::get("log");
+
+  if (ec == std::errc::timed_out) {
+    SPDLOG_TRACE(log, "complete_trial: timeout");
+    trial.status(TrialStatus::Error::mk(ErrorKind::Timeout::mk(
+            elapsed, std::move(sout), std::move(serr))));
+    return;
+  }
+
+  if (ec) {
+    SPDLOG_TRACE(log, "complete_trial: error_code");
+    trial.status(TrialStatus::Error::mk(ErrorKind::ErrorCode::mk(
+            ec, std::move(sout), std::move(serr))));
+    return;
+  }
+
+  if (result != 0) {
+    SPDLOG_TRACE(log, "complete_trial: exit status");
+    trial.status(TrialStatus::Error::mk(ErrorKind::ExitStatus::mk(
+            result, std::move(sout), std::move(serr))));
+    return;
+  }
+
+  if (parser) {
+    if (parser->finish()) {
+      trial.status(TrialStatus::Complete::mk(
+            std::move(parser->output()), std::move(serr)));
+    } else {
+      SPDLOG_TRACE(log, "complete_trial: bad stdout: {}", parser->error());
+      trial.status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
+              std::move(sout), std::move(serr))));
+    }
+    return;
+  }
+
+  try {
+    SPDLOG_TRACE(log, "complete_trial: parsing stdout");
+    TrialOutput out = json::parse(sout);
+    out.check_aux();
+    SPDLOG_TRACE(log, "complete_trial: parsed stdout");
+
+    trial.status(TrialStatus::Complete::mk(std::move(out), std::move(serr)));
+  } catch (const std::exception &e) {
+    SPDLOG_TRACE(log, "complete_trial: bad stdout");
+    trial.status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
+            std::move(sout), std::move(serr))));
+  }
+}
+
+Zygote &Runner::zygote(const Experiment &exp)
+{
+  auto &ret = zygotes_[exp.name()];
+  if (!ret || !ret->alive()) {
+    ret = std::make_shared<Zygote>(ioc_, exp,
+        plans_.at(exp.name()), capture);
+    ret->start();
+  }
+  return *ret;
+}
+
+PluginPool &Runner::plugin_pool(const Experiment &exp)
+{
+  auto &ret = plugin_pools_[exp.name()];
+  if (!ret) {
+    ret = std::make_unique<PluginPool>(ioc_, exp, std::max(jobs, size_t(1)));
+  }
+  return *ret;
+}
+
+ExecutorPool &Runner::executor_pool(const Experiment &exp)
+{
+  auto &ret = pools_[exp.name()];
+  if (!ret) {
+    ret = std::make_unique<ExecutorPool>(ioc_, exp,
+        plans_.at(exp.name()), capture);
+  }
+  return *ret;
+}
+
+std::shared_ptr<TrialResources> Runner::trial_resources(const Experiment &exp)
+{
+  if (!TrialResources::wanted(exp)) {
+    return nullptr;
+  }
+  if (!cpu_allocator_) {
+    cpu_allocator_ = std::make_unique<CpuAllocator>();
+  }
+  if (cgroup != "" && !cgroup_ready_) {
+    CgroupLeaf::enable_controllers(cgroup);
+    cgroup_ready_ = true;
+  }
+  return std::make_shared<TrialResources>(*cpu_allocator_, cgroup,
+      "royale-" + std::to_string(::getpid()) + "-" +
+      std::to_string(++trial_seq_), exp);
+}
+
 void Runner::exec_experiment_impl(const Experiment &exp, Trial trial,
       std::function<void(Trial)> handler)
 {
@@ -123,92 +445,442 @@ void Runner::exec_experiment_impl(const Experiment &exp, Trial trial,
 
   const auto &cmd = exp.cmd();
 
-  log->info("Running command {}", xtd::lazy_json_dump(cmd));
+  if (exp.timeout() > 0) {
+    trial.input().deadline(exp.timeout() * soft_deadline_fraction);
+  }
 
-  auto path = boost::this_process::path();
-  auto cwd = boost::filesystem::current_path();
-  cwd /= exp.cd();
-  path.push_back(cwd);
+  if (exp.plugin() != "" && !exp.isolate()) {
+    log->info("Running trial on plugin {}", exp.plugin());
+    auto trial_ = xtd::into_shared(std::move(trial));
+    plugin_pool(exp).run(json(trial_->input()).dump(),
+      [log, trial_, handler](int result, std::string sout, double elapsed) {
+        log->info("Plugin returned {}", result);
+        log->info("  output: {}", xtd::lazy_json_dump(sout));
 
-  SPDLOG_DEBUG(log, "Search path: {}", xtd::lazy_json_dump(path));
+        complete_trial(*trial_, result, {}, elapsed, std::move(sout), "");
+        handler(std::move(*trial_));
+      });
+    return;
+  }
 
+  if (exp.protocol() == "persistent" || exp.plugin() != "") {
+    log->info("Running trial on persistent executor {}",
+        xtd::lazy_json_dump(cmd));
+    auto &pool = executor_pool(exp);
+    io::spawn(ioc_,
+      [this, &pool, trial = std::move(trial), handler]
+      (io::yield_context yield) mutable {
+        auto done = xtd::into_shared(pool.run(std::move(trial), yield));
+        io::post(ioc_, [done, handler]() { handler(std::move(*done)); });
+      });
+    return;
+  }
 
-  std::string in = json(trial.input()).dump();
-  auto pin = xtd::into_shared(std::move(in));
+  if (exp.protocol() == "zygote") {
+    log->info("Running trial on zygote {}", xtd::lazy_json_dump(cmd));
+    auto trial_ = xtd::into_shared(std::move(trial));
+    auto start = std::chrono::steady_clock::now();
+    zygote(exp).run(json(trial_->input()).dump(), exp.timeout(),
+      [log, trial_, handler, start](int result, const std::error_code &ec,
+          std::string sout, std::string serr, Zygote::files_type files) {
+        log->info("Zygote child exited with code {}", result);
+        log->info("  ec: {}", ec.message());
+        log->info("  stdout: {}", xtd::lazy_json_dump(sout));
+        log->info("  stderr: {}", xtd::lazy_json_dump(serr));
+
+        trial_->files() = std::move(files);
+        complete_trial(*trial_, result, ec, xtd::seconds_since(start),
+            std::move(sout), std::move(serr));
+        handler(std::move(*trial_));
+      });
+    return;
+  }
 
-  auto pout = std::make_shared<io::streambuf>();
-  auto perr = std::make_shared<io::streambuf>();
+  spawn_trial(exp, std::move(trial), std::move(handler));
+}
 
-  auto cmdpath = bp::search_path(cmd.at(0), std::move(path));
-  SPDLOG_DEBUG(log, "Search result: {}", xtd::lazy_json_dump(cmdpath));
+std::function<void()> Runner::spawn_trial(const Experiment &exp, Trial trial,
+    std::function<void(Trial)> handler)
+{
+  auto log = spdlog::get("log");
 
-  std::error_code ec;
+  log->info("Running command {}", xtd::lazy_json_dump(exp.cmd()));
 
+  auto parser = std::make_shared<TrialOutputParser>();
   auto trial_ = xtd::into_shared(std::move(trial));
+  uint64_t memory_max = exp.memory_max();
+
+  return spawn_executor(exp, json(trial_->input()).dump(),
+    [parser](const char *data, size_t n) { parser->feed(data, n); },
+    [log, trial_, parser, memory_max, handler](SpawnResult r) {
+      trial_->files() = std::move(r.files);
+      if (r.oom) {
+        log->warn("Executor exceeded memory_max of {} bytes", memory_max);
+        trial_->status(TrialStatus::Error::mk(ErrorKind::MemoryLimit::mk(
+                memory_max, std::move(r.sout), std::move(r.serr))));
+      } else {
+        complete_trial(*trial_, r.result, r.ec, r.elapsed,
+            std::move(r.sout), std::move(r.serr), parser.get());
+      }
+      handler(std::move(*trial_));
+    });
+}
 
-  auto child_ = std::make_shared<std::unique_ptr<bp::child>>();
+/// Trials of an experiment to time before any are speculatively re-executed
+static const size_t speculate_min_samples = 20;
 
-  auto on_exit =
-    [=] (int result, const std::error_code &ec) mutable {
-      SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: entered");
-      (void)child_; // Capture child_ to extend lifetime
-      std::string sout((std::istreambuf_iterator<char>(pout.get())),
-                        std::istreambuf_iterator<char>());
-      std::string serr((std::istreambuf_iterator<char>(perr.get())),
-                        std::istreambuf_iterator<char>());
+void Runner::race_trial_impl(const Experiment &exp, Trial trial,
+    std::function<void(Trial)> handler)
+{
+  auto log = spdlog::get("log");
 
-      log->info("Command exited with code {}", result);
-      log->info("  ec: {}", ec.message());
-      log->info("  stdin: {}", *pin);
-      log->info("  stdout: {}", xtd::lazy_json_dump(sout));
-      log->info("  stderr: {}", xtd::lazy_json_dump(serr));
+  struct Race
+  {
+    bool done = false;
+    bool backup = false;
+    std::function<void()> cancel[2];
+    io::steady_timer timer;
+
+    Race(io::io_context &ioc) : timer(ioc) {}
+  };
+  auto race = std::make_shared<Race>(ioc_);
+  auto start = std::chrono::steady_clock::now();
+  auto &runtimes = runtimes_[exp.name()];
+
+  // The first copy to finish wins; the other is killed, and its result
+  // ignored when it arrives
+  auto finish = [this, log, race, start, &runtimes, handler]
+    (size_t which, Trial done) {
+      if (race->done) {
+        return;
+      }
+      race->done = true;
+      race->timer.cancel();
+      if (race->cancel[1 - which]) {
+        race->cancel[1 - which]();
+      }
+      if (race->backup) {
+        --backups_;
+      }
+      if (which == 1) {
+        log->info("Speculative copy of trial won");
+        speculation_.won(speculation_.won() + 1);
+      }
+      runtimes.add(xtd::seconds_since(start));
+      handler(std::move(done));
+    };
 
-      if (ec) {
-        SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: error_code");
-        trial_->status(TrialStatus::Error::mk(ErrorKind::ErrorCode::mk(
-                ec, std::move(sout), std::move(serr))));
-        handler(std::move(*trial_));
+  TrialInput input = trial.input();
+  race->cancel[0] = spawn_trial(exp, std::move(trial),
+      [finish](Trial done) mutable { finish(0, std::move(done)); });
+
+  if (runtimes.count() < speculate_min_samples || race->done) {
+    return;
+  }
+  double threshold = runtimes.percentile(speculate);
+  race->timer.expires_after(xtd::to_duration(threshold));
+  race->timer.async_wait(
+    [this, log, race, &exp, input = std::move(input), threshold, finish]
+    (const boost::system::error_code &ec) mutable {
+      // A copy takes a slot, like any trial, so only starts if one is free
+      if (ec || race->done ||
+          in_flight_ + backups_ >= std::max(jobs, size_t(1))) {
         return;
       }
+      log->info("Trial of \"{}\" running past {}s; starting a copy",
+          exp.name(), threshold);
+      race->backup = true;
+      ++backups_;
+      speculation_.launched(speculation_.launched() + 1);
+      Trial copy;
+      copy.input(std::move(input));
+      race->cancel[1] = spawn_trial(exp, std::move(copy),
+          [finish](Trial done) mutable { finish(1, std::move(done)); });
+    });
+}
 
-      if (result != 0) {
-        SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: exit status");
-        trial_->status(TrialStatus::Error::mk(ErrorKind::ExitStatus::mk(
-                result, std::move(sout), std::move(serr))));
-        handler(std::move(*trial_));
+/// Set the final status of each trial of a batch from the executor's output:
+/// a JSON array with, for each trial in turn, its TrialOutput, or
+/// {"error": ...} if it failed alone. @a output is the whole of stdout, and
+/// @a sout what's kept for error reports.
+static void complete_batch(std::vector<Trial> &trials,
+    const std::string &output, const std::string &sout,
+    const std::string &serr)
+{
+  auto log = spdlog::get("log");
+
+  json outputs;
+  try {
+    outputs = json::parse(output);
+  } catch (const std::exception &e) {
+    SPDLOG_TRACE(log, "complete_batch: bad stdout: {}", e.what());
+  }
+  if (!outputs.is_array() || outputs.size() != trials.size()) {
+    log->warn("Batch executor didn't output an array of {} items",
+        trials.size());
+    for (auto &trial : trials) {
+      trial.status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
+              sout, serr)));
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < trials.size(); ++i) {
+    auto &item = outputs[i];
+    if (item.is_object() && item.count("error") > 0) {
+      trials[i].status(TrialStatus::Error::mk(ErrorKind::ExecutorError::mk(
+              std::move(item["error"]), serr)));
+      continue;
+    }
+    try {
+      TrialOutput out = item;
+      out.check_aux();
+      trials[i].status(TrialStatus::Complete::mk(std::move(out), serr));
+    } catch (const std::exception &) {
+      trials[i].status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
+              item.dump(), serr)));
+    }
+  }
+}
+
+void Runner::exec_batch_impl(const Experiment &exp, std::vector<Trial> trials,
+      std::function<void(std::vector<Trial>)> handler)
+{
+  auto log = spdlog::get("log");
+
+  json inputs = json::array();
+  for (auto &trial : trials) {
+    if (exp.timeout() > 0) {
+      trial.input().deadline(exp.timeout() * soft_deadline_fraction);
+    }
+    inputs.push_back(trial.input());
+  }
+
+  log->info("Running batch of {} on command {}", trials.size(),
+      xtd::lazy_json_dump(exp.cmd()));
+
+  // Batch output is only useful whole, so it's kept whole, beyond the
+  // capture limit
+  auto out = std::make_shared<std::string>();
+  auto trials_ = xtd::into_shared(std::move(trials));
+  uint64_t memory_max = exp.memory_max();
+
+  spawn_executor(exp, inputs.dump(),
+    [out](const char *data, size_t n) { out->append(data, n); },
+    [log, out, trials_, memory_max, handler](SpawnResult r) {
+      for (auto &trial : *trials_) {
+        trial.files() = r.files;
+      }
+      if (r.oom) {
+        log->warn("Executor exceeded memory_max of {} bytes", memory_max);
+        for (auto &trial : *trials_) {
+          trial.status(TrialStatus::Error::mk(ErrorKind::MemoryLimit::mk(
+                  memory_max, r.sout, r.serr)));
+        }
+      } else if (r.ec || r.result != 0) {
+        for (auto &trial : *trials_) {
+          complete_trial(trial, r.result, r.ec, r.elapsed, r.sout, r.serr);
+        }
+      } else {
+        complete_batch(*trials_, *out, r.sout, r.serr);
+      }
+      out->clear();
+      handler(std::move(*trials_));
+    });
+}
+
+std::function<void()> Runner::spawn_executor(const Experiment &exp,
+    std::string input, std::function<void(const char *, size_t)> on_stdout,
+    std::function<void(SpawnResult)> handler)
+{
+  auto log = spdlog::get("log");
+
+  auto pin = xtd::into_shared(std::move(input));
+
+  auto pout = std::make_shared<StreamCapture>(capture, "stdout");
+  auto perr = std::make_shared<StreamCapture>(capture, "stderr");
+  if (on_stdout) {
+    pout->on_data(std::move(on_stdout));
+  }
+  auto out_pipe = std::make_shared<bp::async_pipe>(ioc_);
+  auto err_pipe = std::make_shared<bp::async_pipe>(ioc_);
+
+  const auto &plan = plans_.at(exp.name());
+  auto resources = trial_resources(exp);
+
+  // With the memfd transport, the input is in a sealed memfd, and the
+  // executor writes its output to a second one, which is parsed where it
+  // lies. Anything the executor prints goes to stderr.
+  std::shared_ptr<MemFd> in_fd;
+  std::shared_ptr<MemFd> out_fd;
+  const LaunchPlan *launch = &plan;
+  LaunchPlan memfd_plan;
+  if (exp.transport() == "memfd") {
+    in_fd = std::make_shared<MemFd>("royale-input");
+    in_fd->write(*pin).seal();
+    out_fd = std::make_shared<MemFd>("royale-output");
+    memfd_plan = plan.with_env({
+        {"ROYALE_INPUT_FD", std::to_string(in_fd->fd())},
+        {"ROYALE_OUTPUT_FD", std::to_string(out_fd->fd())},
+      });
+    launch = &memfd_plan;
+  }
+
+  auto child_ = std::make_shared<std::unique_ptr<bp::child>>();
+
+  // The executor runs in its own process group, so a timeout can kill
+  // anything it started, too
+  auto group = std::make_shared<bp::group>();
+  auto timer = std::make_shared<io::steady_timer>(ioc_);
+  auto timed_out = std::make_shared<bool>(false);
+  auto exited = std::make_shared<bool>(false);
+  auto start = std::chrono::steady_clock::now();
+
+  // Reports the result once the executor has exited, and its stdout and
+  // stderr are closed
+  auto exit_status = std::make_shared<std::pair<int, std::error_code>>();
+  auto remaining = std::make_shared<int>(out_fd ? 2 : 3);
+  auto finish = std::make_shared<std::function<void()>>(
+    [=]() mutable {
+      if (--*remaining > 0) {
         return;
       }
+      SPDLOG_TRACE(log, "Runner::spawn_executor::finish: entered");
+      timer->cancel();
+
+      SpawnResult r;
+      r.result = exit_status->first;
+      r.ec = exit_status->second;
+      r.elapsed = xtd::seconds_since(start);
+      if (out_fd) {
+        try {
+          auto output = out_fd->map();
+          pout->append(output.data(), output.size());
+        } catch (const std::exception &e) {
+          log->error("Couldn't read executor output memfd: {}", e.what());
+        }
+        out_fd.reset();
+      }
+      r.sout = pout->str();
+      r.serr = perr->str();
 
-      try {
-        SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: parsing stdout");
-        TrialOutput out = json::parse(sout);
-        SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: parsed stdout");
+      log->info("Command exited with code {}", r.result);
+      log->info("  ec: {}", r.ec.message());
+      log->info("  stdin: {}", *pin);
+      log->info("  stdout: {}", xtd::lazy_json_dump(r.sout));
+      log->info("  stderr: {}", xtd::lazy_json_dump(r.serr));
 
-        trial_->status(TrialStatus::Complete::mk(std::move(out), std::move(serr)));
-      } catch (const std::exception &e) {
-        SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: bad stdout");
-        trial_->status(TrialStatus::Error::mk(ErrorKind::BadOutput::mk(
-                std::move(sout), std::move(serr))));
+      if (pout->spill_path() != "") {
+        r.files["stdout"] = pout->spill_path();
+      }
+      if (perr->spill_path() != "") {
+        r.files["stderr"] = perr->spill_path();
       }
+      r.oom = resources && resources->oom_killed();
 
-      SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: calling handler");
-      handler(std::move(*trial_));
-      SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: called handler");
+      // Free the trial's CPUs, cgroup, and capture buffers before handing off
+      // the result
+      resources.reset();
+      pout.reset();
+      perr.reset();
+
+      SPDLOG_TRACE(log, "Runner::spawn_executor::finish: calling handler");
+      handler(std::move(r));
+      SPDLOG_TRACE(log, "Runner::spawn_executor::finish: called handler");
+    });
+
+  auto on_exit =
+    [=] (int result, std::error_code ec) mutable {
+      SPDLOG_TRACE(log, "Runner::spawn_executor::on_exit: entered");
+      (void)child_; // Capture child_ to extend lifetime
+      timer->cancel();
+      if (*timed_out) {
+        ec = std::make_error_code(std::errc::timed_out);
+      } else {
+        group->detach();
+      }
+      *exited = true;
+      *exit_status = std::make_pair(result, ec);
+
+      // Anything the executor left running may hold its stdout or stderr
+      // open; don't wait on it for long
+      timer->expires_after(xtd::to_duration(output_grace));
+      timer->async_wait(
+        [out_pipe, err_pipe](const boost::system::error_code &ec) {
+          if (ec) {
+            return;
+          }
+          boost::system::error_code cec;
+          out_pipe->close(cec);
+          err_pipe->close(cec);
+        });
 
-      SPDLOG_TRACE(log, "Runner::exec_experiment::on_exit: leaving");
+      (*finish)();
+      SPDLOG_TRACE(log, "Runner::spawn_executor::on_exit: leaving");
     };
 
-  SPDLOG_TRACE(log, "Runner::exec_experiment: creating child");
-  *child_ = std::make_unique<bp::child>(
-      cmdpath.string(),
-      bp::args(cmd),
-      bp::std_in < io::buffer(*pin),
-      bp::std_out > *pout,
-      bp::std_err > *perr,
-      bp::start_dir(exp.cd()),
-      bp::on_exit(on_exit),
-      ioc_);
-  SPDLOG_TRACE(log, "Runner::exec_experiment: created child");
+  auto make_child = [&](auto &&... redirects) {
+    *child_ = std::make_unique<bp::child>(
+        launch->exe().string(),
+        bp::args(launch->args()),
+        std::forward<decltype(redirects)>(redirects)...,
+        launch->env_init(),
+        bp::start_dir(launch->start_dir().string()),
+        bp::extend::on_exec_setup([resources, in_fd, out_fd](auto &) {
+            if (in_fd) {
+              in_fd->inherit();
+              out_fd->inherit();
+            }
+            if (resources) {
+              resources->apply();
+            }
+          }),
+        bp::on_exit(on_exit),
+        *group,
+        ioc_);
+  };
+
+  SPDLOG_TRACE(log, "Runner::spawn_executor: creating child");
+  if (out_fd) {
+    make_child(bp::std_in < bp::null,
+        (bp::std_out & bp::std_err) > *err_pipe);
+  } else {
+    make_child(bp::std_in < io::buffer(*pin), bp::std_out > *out_pipe,
+        bp::std_err > *err_pipe);
+  }
+  SPDLOG_TRACE(log, "Runner::spawn_executor: created child");
+
+  // The parent's copy of the input is only needed until the child has it
+  in_fd.reset();
+
+  if (!out_fd) {
+    async_capture(out_pipe, pout, [finish]() { (*finish)(); });
+  } else {
+    boost::system::error_code cec;
+    out_pipe->close(cec);
+  }
+  async_capture(err_pipe, perr, [finish]() { (*finish)(); });
+
+  if (exp.timeout() > 0) {
+    timer->expires_after(xtd::to_duration(exp.timeout()));
+    timer->async_wait(
+      [log, group, timed_out](const boost::system::error_code &ec) {
+        if (ec) {
+          return;
+        }
+        log->warn("Executor timed out; killing its process group");
+        *timed_out = true;
+        std::error_code tec;
+        group->terminate(tec);
+      });
+  }
+
+  return [group, exited]() {
+      if (!*exited) {
+        std::error_code ec;
+        group->terminate(ec);
+      }
+    };
 }
 
 void Runner::connect_to(std::string host, std::string port,
@@ -256,7 +928,11 @@ std::vector<Trial> Runner::run_batch(const std::string &name,
     std::vector<Trial> ret;
     resp.visit(xtd::overload(
       [&](Message::BatchDone &resp) {
+        BlobStore blobs(std::move(resp.blobs()));
         ret = std::move(resp.trials());
+        for (auto &trial : ret) {
+          trial.internalize(blobs);
+        }
       },
       [](Message &msg) {
         throw std::runtime_error(
@@ -307,6 +983,145 @@ std::vector<Trial> Runner::run_batch(const std::string &name,
   }
 }
 
+void Runner::run_trials(const std::string &name, size_t count,
+    std::function<void(Trial)> on_trial, io::yield_context yield,
+    std::function<bool()> stop)
+{
+  shares_type shares;
+  shares[name].count = count;
+  run_shared(shares, std::move(on_trial), yield, std::move(stop));
+}
+
+void Runner::run_shared(const shares_type &shares,
+    std::function<void(Trial)> on_trial, io::yield_context yield,
+    std::function<bool()> stop)
+{
+  auto log = spdlog::get("log");
+
+  struct Issue
+  {
+    size_t count;
+    double weight;
+    size_t batch = 1;
+    size_t issued = 0;
+    size_t in_flight = 0;
+  };
+  std::map<std::string, Issue> issues;
+
+  // Units of work are single trials, or batches of Experiment::batch_size
+  // local trials, if set
+  size_t units = 0;
+  size_t total = 0;
+  for (const auto &share : shares) {
+    if (share.second.count == 0) {
+      continue;
+    }
+    if (!(share.second.weight > 0)) {
+      throw std::runtime_error("Share of experiment \"" + share.first +
+          "\" must have a positive weight");
+    }
+    Issue issue{share.second.count, share.second.weight};
+    auto e = experiments_.find(share.first);
+    if (!remote() && e != experiments_.end() &&
+        e->second->batch_size() > 1 && e->second->protocol() == "spawn" &&
+        e->second->plugin() == "") {
+      issue.batch = e->second->batch_size();
+    }
+    units += issue.count / issue.batch + (issue.count % issue.batch != 0);
+    total += issue.count;
+    issues.emplace(share.first, issue);
+  }
+
+  // A remote stream can only carry one request at a time
+  size_t workers = remote() ? 1 : std::max(jobs, size_t(1));
+  workers = std::min(workers, units);
+
+  if (issues.size() == 1) {
+    log->info("Runner::run_trials: running {} trials of \"{}\" on {} slots",
+        total, issues.begin()->first, workers);
+  } else {
+    log->info("Runner::run_shared: running {} trials of {} experiments on {} "
+        "slots", total, issues.size(), workers);
+  }
+
+  // The experiment to start a unit of next, or issues.end() if none
+  auto pick = [&]() {
+    auto ret = issues.end();
+    if (stop && stop()) {
+      return ret;
+    }
+    for (auto i = issues.begin(); i != issues.end(); ++i) {
+      const auto &cur = i->second;
+      if (cur.issued >= cur.count) {
+        continue;
+      }
+      if (ret == issues.end()) {
+        ret = i;
+        continue;
+      }
+      const auto &best = ret->second;
+      double load = cur.in_flight / cur.weight;
+      double best_load = best.in_flight / best.weight;
+      if (load < best_load || (load == best_load &&
+            cur.issued / cur.weight < best.issued / best.weight)) {
+        ret = i;
+      }
+    }
+    return ret;
+  };
+
+  xtd::CoroutineWaiter waiter(ioc());
+  for (size_t i = 0; i < workers; ++i) {
+    waiter.spawn(
+      [this, &issues, &pick, &on_trial, &log]
+      (io::yield_context yield) mutable
+      {
+        for (auto next = pick(); next != issues.end(); next = pick()) {
+          const std::string &name = next->first;
+          auto &issue = next->second;
+          size_t k = std::min(issue.batch, issue.count - issue.issued);
+          issue.issued += k;
+          ++issue.in_flight;
+          ++in_flight_;
+
+          // The inputs are kept, so a failed trial still has its sample,
+          // seq, and weight
+          std::vector<Trial> trials;
+          std::vector<TrialInput> inputs;
+          for (size_t j = 0; j < k; ++j) {
+            trials.emplace_back(new_trial(name));
+            inputs.emplace_back(trials.back().input());
+          }
+          try {
+            if (issue.batch > 1) {
+              trials = exec_batch(*experiments_.at(name), std::move(trials),
+                  yield);
+            } else {
+              trials.front() = run_trial(std::move(trials.front()), yield);
+            }
+          } catch (const std::exception &e) {
+            xtd::log_exception(log, "RunTrials", std::current_exception());
+            trials.clear();
+            for (auto &input : inputs) {
+              Trial trial;
+              trial.input(std::move(input));
+              trial.exception(e);
+              trials.emplace_back(std::move(trial));
+            }
+          }
+
+          --issue.in_flight;
+          --in_flight_;
+          for (auto &trial : trials) {
+            on_trial(std::move(trial));
+          }
+        }
+      });
+  }
+  SPDLOG_TRACE(log, "RunTrials: waiting for {} workers", workers);
+  waiter.async_wait(workers, yield);
+}
+
 bool Runner::handle_request(Runner::stream_type &stream,
     Message::Enum req, io::yield_context yield)
 {
@@ -323,7 +1138,10 @@ bool Runner::handle_request(Runner::stream_type &stream,
       try {
         auto e = experiments_.find(name);
         if (e != experiments_.end()) {
-          trial = exec_experiment(*e->second, std::move(trial), yield);
+          if (!recall(*e->second, trial)) {
+            trial = exec_experiment(*e->second, std::move(trial), yield);
+            remember(*e->second, trial);
+          }
         } else {
           trial.status(TrialStatus::Error::mk(
                 ErrorKind::UnknownExperiment::mk(name)));
@@ -360,7 +1178,15 @@ bool Runner::handle_request(Runner::stream_type &stream,
 
       std::string name = std::move(run.experiment_name());
       auto results = run_batch(name, yield);
+
+      // Identical output across the batch, such as the same warnings on
+      // every trial's stderr, goes over the wire once
+      BlobStore blobs;
+      for (auto &trial : results) {
+        trial.externalize(blobs, blob_min);
+      }
       auto resp = Message::BatchDone::mk(std::move(name), std::move(results));
+      resp->blobs(std::move(blobs.blobs()));
       send_message(stream, std::move(resp), yield);
       SPDLOG_TRACE(spdlog::get("log"),
           "Runner::handle_request Ran batch");
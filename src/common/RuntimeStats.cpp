@@ -0,0 +1,34 @@
+#include <royale/RuntimeStats.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace royale {
+
+void RuntimeStats::add(double seconds)
+{
+  if (max_ == 0) {
+    return;
+  }
+  if (window_.size() < max_) {
+    window_.push_back(seconds);
+  } else {
+    window_[next_] = seconds;
+    next_ = (next_ + 1) % max_;
+  }
+}
+
+double RuntimeStats::percentile(double p) const
+{
+  if (window_.empty()) {
+    return 0;
+  }
+  std::vector<double> sorted = window_;
+  size_t rank = std::ceil(std::min(std::max(p, 0.0), 100.0) / 100 *
+      sorted.size());
+  rank = std::max(rank, size_t(1)) - 1;
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  return sorted[rank];
+}
+
+} // namespace royale
@@ -0,0 +1,131 @@
+#include <royale/SampleAllocator.hpp>
+
+#include <cmath>
+#include <royale/IntervalEstimate.hpp>
+
+namespace royale {
+
+namespace {
+
+double projected_half_width(double prob, size_t n, double confidence)
+{
+  auto bounds = wilson_interval(std::llround(prob * n), n, confidence);
+  return (bounds.second - bounds.first) / 2;
+}
+
+} // namespace
+
+SampleAllocator::SampleAllocator(const std::vector<std::string> &experiments,
+    size_t budget, double confidence, std::string method)
+  : budget_(budget), method_(std::move(method)), confidence_(confidence)
+{
+  if (experiments.empty()) {
+    throw std::runtime_error("No experiments to allocate trials among");
+  }
+  // Validates method_ and confidence_
+  PredicateOutput().interval(method_, confidence_);
+
+  for (const auto &name : experiments) {
+    experiments_[name];
+  }
+}
+
+double SampleAllocator::projected(const ExperimentAllocation &exp,
+    size_t extra) const
+{
+  if (exp.preds().empty()) {
+    return projected_half_width(0.5, exp.trials() + extra, confidence_);
+  }
+  double ret = 0;
+  for (const auto &pred : exp.preds()) {
+    const auto &output = pred.second;
+    size_t n = output.count() - output.error_count() + extra;
+    ret = std::max(ret, projected_half_width(output.prob(), n, confidence_));
+  }
+  return ret;
+}
+
+SampleAllocator::counts_type SampleAllocator::next(size_t n)
+{
+  n = std::min(n, budget_ - std::min(budget_, spent_));
+
+  counts_type ret;
+  for (size_t i = 0; i < n; ++i) {
+    // The experiment whose widest interval, after the trials given it so
+    // far this round, is widest; ties go to the one with fewer trials
+    auto best = experiments_.end();
+    double best_width = -1;
+    size_t best_trials = 0;
+    for (auto e = experiments_.begin(); e != experiments_.end(); ++e) {
+      size_t extra = ret.count(e->first) > 0 ? ret[e->first] : 0;
+      double width = projected(e->second, extra);
+      size_t trials = e->second.trials() + extra;
+      if (width > best_width ||
+          (width == best_width && trials < best_trials)) {
+        best = e;
+        best_width = width;
+        best_trials = trials;
+      }
+    }
+    ++ret[best->first];
+  }
+  return ret;
+}
+
+void SampleAllocator::update(ExperimentAllocation &exp)
+{
+  exp.half_width(exp.preds().empty() ? 0.5 : 0);
+  for (auto &pred : exp.preds()) {
+    pred.second.interval(method_, confidence_);
+    exp.half_width(std::max(exp.half_width(), pred.second.half_width()));
+  }
+  half_width_ = 0;
+  for (const auto &e : experiments_) {
+    half_width_ = std::max(half_width_, e.second.half_width());
+  }
+}
+
+void SampleAllocator::add(const Trial &trial)
+{
+  auto e = experiments_.find(trial.input().experiment_name());
+  if (e == experiments_.end()) {
+    return;
+  }
+  auto &exp = e->second;
+  exp.trials(exp.trials() + 1);
+  ++spent_;
+
+  const TrialOutput *complete_output = nullptr;
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      complete_output = &complete.output();
+    },
+    [&](const TrialStatus &) {}));
+
+  if (complete_output) {
+    for (const auto &pred : complete_output->preds()) {
+      auto &output = exp.preds()[pred.first];
+      if (output.name().empty()) {
+        // Trials before this one didn't give it
+        output.name(pred.first);
+        for (size_t i = 1; i < exp.trials(); ++i) {
+          output.add_error();
+        }
+      }
+      if (pred.second) {
+        output.add_sat(trial.input().weight());
+      } else {
+        output.add_unsat(trial.input().weight());
+      }
+    }
+  }
+  for (auto &pred : exp.preds()) {
+    auto &output = pred.second;
+    if (output.count() < exp.trials()) {
+      output.add_error();
+    }
+  }
+  update(exp);
+}
+
+} // namespace royale
@@ -0,0 +1,85 @@
+#include <royale/SequentialTest.hpp>
+
+#include <cmath>
+#include <regex>
+
+namespace royale {
+
+SequentialTest::SequentialTest(const std::string &spec, double alpha,
+    double beta, double indifference)
+  : alpha_(alpha), beta_(beta), indifference_(indifference)
+{
+  static const std::regex re(R"(\s*(\S+)\s*(>=|<=)\s*(\S+)\s*)");
+  std::smatch m;
+  if (!std::regex_match(spec, m, re)) {
+    throw std::runtime_error("Bad test \"" + spec + "\"; expected like "
+        "\"pred >= 0.5\"");
+  }
+  pred_ = m[1];
+  op_ = m[2];
+  try {
+    bound_ = std::stod(m[3]);
+  } catch (const std::logic_error &) {
+    throw std::runtime_error("Bad bound in test \"" + spec + "\"");
+  }
+
+  if (!(alpha_ > 0 && alpha_ < 1 && beta_ > 0 && beta_ < 1)) {
+    throw std::runtime_error("Test alpha and beta must be within (0, 1)");
+  }
+  if (!(indifference_ > 0 && bound_ - indifference_ > 0 &&
+        bound_ + indifference_ < 1)) {
+    throw std::runtime_error("Test bound, give or take the indifference, must "
+        "be within (0, 1)");
+  }
+
+  output_.name(pred_);
+}
+
+bool SequentialTest::add(const Trial &trial)
+{
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      const auto &preds = complete.output().preds();
+      auto i = preds.find(pred_);
+      if (i != preds.end()) {
+        add(i->second);
+      } else {
+        output_.add_error();
+      }
+    },
+    [&](const TrialStatus &) {
+      output_.add_error();
+    }));
+  return decided();
+}
+
+bool SequentialTest::add(bool sat)
+{
+  if (sat) {
+    output_.add_sat();
+  } else {
+    output_.add_unsat();
+  }
+  if (decided()) {
+    return true;
+  }
+
+  // Probability of sat if the property holds by the indifference, and if it
+  // fails by it
+  double p_holds = op_ == ">=" ? bound_ + indifference_ :
+    bound_ - indifference_;
+  double p_fails = op_ == ">=" ? bound_ - indifference_ :
+    bound_ + indifference_;
+
+  llr_ += sat ? std::log(p_fails / p_holds) :
+    std::log((1 - p_fails) / (1 - p_holds));
+
+  if (llr_ >= std::log((1 - beta_) / alpha_)) {
+    decision_ = "fails";
+  } else if (llr_ <= std::log(beta_ / (1 - alpha_))) {
+    decision_ = "holds";
+  }
+  return decided();
+}
+
+} // namespace royale
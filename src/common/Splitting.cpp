@@ -0,0 +1,132 @@
+#include <royale/Splitting.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace royale {
+
+MultilevelSplitting::MultilevelSplitting(levels_type levels, size_t effort,
+    unsigned int seed)
+  : levels_(std::move(levels)), effort_(effort), random_(seed)
+{
+  if (levels_.empty() || effort_ == 0) {
+    throw std::runtime_error("Splitting needs at least one level, and a "
+        "positive effort");
+  }
+  for (size_t i = 1; i < levels_.size(); ++i) {
+    if (levels_[i] <= levels_[i - 1]) {
+      throw std::runtime_error("Splitting levels must increase");
+    }
+  }
+}
+
+std::vector<Trial> MultilevelSplitting::stage_trials(const Experiment &exp)
+{
+  std::vector<Trial> ret;
+  ret.reserve(effort_);
+
+  auto make = [&](Trial trial, json state) {
+    trial.input().replicate({
+        {"level", levels_[stage_]},
+        {"state", std::move(state)},
+        {"seed", random_()}});
+    ret.emplace_back(std::move(trial));
+  };
+
+  if (stage_ == 0) {
+    for (size_t i = 0; i < effort_; ++i) {
+      make(Trial(exp.name(), exp.inputs().sample()), nullptr);
+    }
+    return ret;
+  }
+
+  // Each start gets an even share of copies, and the furthest along get
+  // the remainder
+  std::stable_sort(starts_.begin(), starts_.end(),
+      [](const Start &a, const Start &b) { return a.score > b.score; });
+  size_t each = effort_ / starts_.size();
+  size_t extra = effort_ % starts_.size();
+  for (size_t i = 0; i < starts_.size(); ++i) {
+    const auto &start = starts_[i];
+    for (size_t j = 0; j < each + (i < extra); ++j) {
+      make(Trial(exp.name(), start.sample), start.state);
+    }
+  }
+  return ret;
+}
+
+void MultilevelSplitting::add(const Trial &trial)
+{
+  if (runs_.size() <= stage_) {
+    runs_.resize(stage_ + 1);
+    hits_.resize(stage_ + 1);
+  }
+
+  double score = 0;
+  json state;
+  bool scored = false;
+  trial.status().visit(xtd::overload(
+    [&](const TrialStatus::Complete &complete) {
+      const json &rep = complete.output().replicate();
+      if (rep.is_object() && rep.count("score") > 0 &&
+          rep["score"].is_number()) {
+        score = rep["score"];
+        if (rep.count("state") > 0) {
+          state = rep["state"];
+        }
+        scored = true;
+      }
+    },
+    [&](const TrialStatus &) {}));
+
+  if (!scored) {
+    ++error_count_;
+    return;
+  }
+  ++runs_[stage_];
+  if (score >= levels_[stage_]) {
+    ++hits_[stage_];
+    reached_.push_back({trial.sample(), std::move(state), score});
+  }
+}
+
+void MultilevelSplitting::next_stage()
+{
+  if (done()) {
+    return;
+  }
+  if (runs_.size() <= stage_) {
+    runs_.resize(stage_ + 1);
+    hits_.resize(stage_ + 1);
+  }
+
+  double p = runs_[stage_] > 0 ? hits_[stage_] / (double)runs_[stage_] : 0;
+  level_probs_.push_back(p);
+
+  prob_ = 1;
+  double rel_var = 0;
+  for (size_t i = 0; i < level_probs_.size(); ++i) {
+    prob_ *= level_probs_[i];
+    if (level_probs_[i] > 0) {
+      rel_var += (1 - level_probs_[i]) / (runs_[i] * level_probs_[i]);
+    }
+  }
+  rel_error_ = prob_ > 0 ? std::sqrt(rel_var) : 0;
+
+  starts_ = std::move(reached_);
+  reached_.clear();
+  ++stage_;
+}
+
+void MultilevelSplitting::stop()
+{
+  if (done()) {
+    return;
+  }
+  if (runs_.size() > stage_ && runs_[stage_] > 0) {
+    next_stage();
+  }
+  stopped_ = !done();
+}
+
+} // namespace royale
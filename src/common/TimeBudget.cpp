@@ -0,0 +1,52 @@
+#include <royale/TimeBudget.hpp>
+
+namespace royale {
+
+TimeBudget::TimeBudget(const std::string &spec)
+{
+  double scale = 1;
+  std::string number = spec;
+  if (!spec.empty()) {
+    switch (spec.back()) {
+      case 's': scale = 1; number.pop_back(); break;
+      case 'm': scale = 60; number.pop_back(); break;
+      case 'h': scale = 3600; number.pop_back(); break;
+    }
+  }
+  size_t end = 0;
+  try {
+    seconds_ = std::stod(number, &end) * scale;
+  } catch (const std::logic_error &) {
+    end = 0;
+  }
+  if (end == 0 || end != number.size()) {
+    throw std::runtime_error("Can't parse duration \"" + spec +
+        "\"; expected seconds, or minutes or hours like 30m or 2h");
+  }
+  if (!(seconds_ > 0)) {
+    throw std::runtime_error("Duration must be positive");
+  }
+}
+
+void TimeBudget::start()
+{
+  if (!started_) {
+    started_at_ = std::chrono::steady_clock::now();
+    started_ = true;
+  }
+}
+
+bool TimeBudget::expired() const
+{
+  return started_ && xtd::seconds_since(started_at_) >= seconds_;
+}
+
+void TimeBudget::finish()
+{
+  if (started_) {
+    elapsed_ = xtd::seconds_since(started_at_);
+  }
+  throughput_ = elapsed_ > 0 ? trials_ / elapsed_ : 0;
+}
+
+} // namespace royale
@@ -0,0 +1,86 @@
+#include <royale/Trial.hpp>
+#include <royale/IntervalEstimate.hpp>
+
+namespace royale {
+
+namespace {
+
+/// Digest of an externalized aux value, or nullptr if @a v is held inline
+const json *aux_blob(const json &v)
+{
+  if (v.is_object() && v.size() == 1) {
+    auto i = v.find("$blob");
+    if (i != v.end() && i->is_string()) {
+      return &*i;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+json TrialOutput::aux(const std::string &key) const
+{
+  const json &v = aux_.at(key);
+  if (auto digest = aux_blob(v)) {
+    return json::parse(Blob::ref(digest->get<std::string>()).text());
+  }
+  return v;
+}
+
+void TrialOutput::externalize_aux(BlobStore &store, size_t min_size)
+{
+  for (auto &entry : aux_) {
+    if (aux_blob(entry.second)) {
+      continue;
+    }
+    std::string text = entry.second.dump();
+    if (text.size() >= min_size) {
+      entry.second = {{"$blob", store.put(text)}};
+    }
+  }
+}
+
+void TrialOutput::check_aux() const
+{
+  for (const auto &entry : aux_) {
+    if (entry.second.is_object() && entry.second.count("$blob") > 0) {
+      throw std::runtime_error("aux \"" + entry.first + "\" uses the "
+          "reserved key \"$blob\"");
+    }
+  }
+}
+
+void TrialOutput::internalize_aux(const BlobStore &store)
+{
+  for (auto &entry : aux_) {
+    if (auto digest = aux_blob(entry.second)) {
+      entry.second = json::parse(store.get(digest->get<std::string>()));
+    }
+  }
+}
+
+PredicateOutput &PredicateOutput::interval(const std::string &method,
+    double confidence)
+{
+  size_t n = count_ - error_count_;
+  std::pair<double, double> bounds;
+  if (method != "wilson" && method != "clopper-pearson") {
+    throw std::runtime_error("Unknown interval method \"" + method +
+        "\"; expected \"wilson\" or \"clopper-pearson\"");
+  }
+  if (weighted_) {
+    bounds = weighted_interval(sat_weight_, sat_weight_sq_, n, confidence);
+  } else if (method == "wilson") {
+    bounds = wilson_interval(sat_count_, n, confidence);
+  } else {
+    bounds = clopper_pearson_interval(sat_count_, n, confidence);
+  }
+  confidence_ = confidence;
+  lower_ = bounds.first;
+  upper_ = bounds.second;
+  rel_error_ = prob_ > 0 ? half_width() / prob_ : 0;
+  return *this;
+}
+
+} // namespace royale
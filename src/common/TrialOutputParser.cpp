@@ -0,0 +1,493 @@
+#include <royale/TrialOutputParser.hpp>
+
+namespace royale {
+
+namespace {
+
+// Expected next token in an object or array
+const int expect_key_or_end = 0;   // just after '{'
+const int expect_key = 1;          // after ',' in an object
+const int expect_value_or_end = 0; // just after '['
+const int expect_value = 1;        // after ',' in an array
+const int expect_colon = 2;
+const int expect_member = 3;       // after ':'
+const int expect_comma_or_end = 4;
+
+// Kinds of values, for routing
+const int kind_scalar = 0;
+const int kind_object = 1;
+const int kind_array = 2;
+
+/// True if @a s is well-formed UTF-8, as json::parse requires: no overlong
+/// forms, surrogates, or code points past U+10FFFF
+bool valid_utf8(const std::string &s)
+{
+  size_t i = 0;
+  while (i < s.size()) {
+    unsigned char c = s[i];
+    size_t len;
+    unsigned cp;
+    if (c < 0x80) {
+      ++i;
+      continue;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+      len = 2;
+      cp = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      len = 3;
+      cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      len = 4;
+      cp = c & 0x07;
+    } else {
+      return false;
+    }
+    if (s.size() - i < len) {
+      return false;
+    }
+    for (size_t j = 1; j < len; ++j) {
+      unsigned char cc = s[i + j];
+      if ((cc & 0xC0) != 0x80) {
+        return false;
+      }
+      cp = (cp << 6) | (cc & 0x3F);
+    }
+    if ((len == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) ||
+        (len == 4 && (cp < 0x10000 || cp > 0x10FFFF))) {
+      return false;
+    }
+    i += len;
+  }
+  return true;
+}
+
+bool is_ws(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int hex_value(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+} // namespace
+
+json &TrialOutputParser::Builder::place(json v)
+{
+  if (stack.empty()) {
+    *root = std::move(v);
+    return *root;
+  }
+  json &top = *stack.back();
+  if (top.is_object()) {
+    return top[key] = std::move(v);
+  }
+  top.push_back(std::move(v));
+  return top.back();
+}
+
+void TrialOutputParser::fail(const std::string &msg)
+{
+  if (error_ == "") {
+    error_ = msg;
+  }
+}
+
+bool TrialOutputParser::begin_value()
+{
+  if (stack_.empty()) {
+    if (started_) {
+      fail("unexpected value after output");
+      return false;
+    }
+    started_ = true;
+    return true;
+  }
+  const auto &top = stack_.back();
+  if (top.object ? top.expect == expect_member :
+      (top.expect == expect_value_or_end || top.expect == expect_value)) {
+    return true;
+  }
+  fail(top.object ? "expected object key" : "expected ',' or ']'");
+  return false;
+}
+
+void TrialOutputParser::after_value()
+{
+  if (stack_.empty()) {
+    lex_ = Lex::Done;
+  } else {
+    stack_.back().expect = expect_comma_or_end;
+  }
+}
+
+bool TrialOutputParser::route_value(int kind, const json *v)
+{
+  int depth = stack_.size();
+
+  if (builder_depth_ < 0) {
+    json *root = nullptr;
+    if (depth == 0) {
+      if (kind != kind_object) {
+        fail("output is not a JSON object");
+        return false;
+      }
+      return true;
+    } else if (depth == 1) {
+      switch (section_) {
+        case Section::Preds:
+        case Section::Aux:
+          if (kind != kind_object) {
+            fail(std::string("\"") +
+                (section_ == Section::Preds ? "preds" : "aux") +
+                "\" is not an object");
+            return false;
+          }
+          return true;
+        case Section::Replicate:
+          root = &output_.replicate();
+          break;
+        default:
+          discard_ = nullptr;
+          root = &discard_;
+          break;
+      }
+    } else if (section_ == Section::Preds) {
+      if (kind != kind_scalar || !v->is_boolean()) {
+        fail("pred \"" + key2_ + "\" is not a boolean");
+        return false;
+      }
+      output_.preds()[key2_] = v->get<bool>();
+      return true;
+    } else {
+      root = &output_.aux()[key2_];
+    }
+    builder_.root = root;
+    builder_.stack.clear();
+    builder_depth_ = depth;
+  }
+
+  if (kind == kind_scalar) {
+    builder_.place(*v);
+    if (depth == builder_depth_) {
+      builder_depth_ = -1;
+    }
+  } else {
+    json &c = builder_.place(kind == kind_object ?
+        json::object() : json::array());
+    builder_.stack.emplace_back(&c);
+  }
+  return true;
+}
+
+void TrialOutputParser::scalar(json v)
+{
+  if (!begin_value() || !route_value(kind_scalar, &v)) {
+    return;
+  }
+  after_value();
+}
+
+void TrialOutputParser::start(bool object)
+{
+  if (!begin_value() ||
+      !route_value(object ? kind_object : kind_array, nullptr)) {
+    return;
+  }
+  stack_.push_back(Frame{object, 0});
+}
+
+void TrialOutputParser::end(bool object)
+{
+  if (stack_.empty() || stack_.back().object != object) {
+    fail(object ? "unexpected '}'" : "unexpected ']'");
+    return;
+  }
+  int expect = stack_.back().expect;
+  if (expect != expect_comma_or_end &&
+      expect != (object ? expect_key_or_end : expect_value_or_end)) {
+    fail(object ? "unexpected '}'" : "unexpected ']'");
+    return;
+  }
+  stack_.pop_back();
+
+  if (builder_depth_ >= 0) {
+    builder_.stack.pop_back();
+    if (int(stack_.size()) == builder_depth_) {
+      builder_depth_ = -1;
+    }
+  }
+  after_value();
+}
+
+void TrialOutputParser::key(std::string k)
+{
+  int depth = stack_.size();
+  if (builder_depth_ >= 0) {
+    if (section_ == Section::Aux && depth == builder_depth_ + 1 &&
+        k == "$blob") {
+      fail("aux \"" + key2_ + "\" uses the reserved key \"$blob\"");
+      return;
+    }
+    builder_.key = std::move(k);
+  } else if (depth == 1) {
+    section_ = k == "preds" ? Section::Preds :
+      k == "aux" ? Section::Aux :
+      k == "replicate" ? Section::Replicate :
+      Section::Other;
+  } else {
+    key2_ = std::move(k);
+  }
+  stack_.back().expect = expect_colon;
+}
+
+void TrialOutputParser::punct(char c)
+{
+  switch (c) {
+    case '{':
+    case '[':
+      start(c == '{');
+      return;
+    case '}':
+    case ']':
+      end(c == '}');
+      return;
+    case ':':
+      if (stack_.empty() || stack_.back().expect != expect_colon) {
+        fail("unexpected ':'");
+        return;
+      }
+      stack_.back().expect = expect_member;
+      return;
+    case ',':
+      if (stack_.empty() || stack_.back().expect != expect_comma_or_end) {
+        fail("unexpected ','");
+        return;
+      }
+      stack_.back().expect = stack_.back().object ? expect_key : expect_value;
+      return;
+  }
+}
+
+void TrialOutputParser::finish_number()
+{
+  json v;
+  try {
+    v = json::parse(token_);
+  } catch (const std::exception &) {
+    fail("bad number \"" + token_ + "\"");
+    return;
+  }
+  scalar(std::move(v));
+}
+
+void TrialOutputParser::finish_literal()
+{
+  if (token_ == "true") {
+    scalar(true);
+  } else if (token_ == "false") {
+    scalar(false);
+  } else if (token_ == "null") {
+    scalar(nullptr);
+  } else {
+    fail("unexpected \"" + token_ + "\"");
+  }
+}
+
+void TrialOutputParser::finish_string()
+{
+  // Raw bytes are copied as they come, so check them here, or a bad string
+  // would only be found when the trial is dumped
+  if (!valid_utf8(token_)) {
+    fail("invalid UTF-8 in string");
+    token_.clear();
+    return;
+  }
+  if (string_is_key_) {
+    key(std::move(token_));
+  } else {
+    scalar(json(std::move(token_)));
+  }
+  token_.clear();
+}
+
+void TrialOutputParser::append_utf8(unsigned cp)
+{
+  if (cp < 0x80) {
+    token_ += char(cp);
+  } else if (cp < 0x800) {
+    token_ += char(0xC0 | (cp >> 6));
+    token_ += char(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    token_ += char(0xE0 | (cp >> 12));
+    token_ += char(0x80 | ((cp >> 6) & 0x3F));
+    token_ += char(0x80 | (cp & 0x3F));
+  } else {
+    token_ += char(0xF0 | (cp >> 18));
+    token_ += char(0x80 | ((cp >> 12) & 0x3F));
+    token_ += char(0x80 | ((cp >> 6) & 0x3F));
+    token_ += char(0x80 | (cp & 0x3F));
+  }
+}
+
+void TrialOutputParser::feed(const char *data, size_t n)
+{
+  size_t i = 0;
+  while (i < n && !failed()) {
+    char c = data[i];
+    switch (lex_) {
+      case Lex::Ws:
+      case Lex::Done:
+        ++i;
+        if (is_ws(c)) {
+          break;
+        }
+        if (lex_ == Lex::Done) {
+          fail("unexpected characters after output");
+        } else if (c == '"') {
+          lex_ = Lex::String;
+          token_.clear();
+          string_is_key_ = !stack_.empty() && stack_.back().object &&
+            (stack_.back().expect == expect_key_or_end ||
+             stack_.back().expect == expect_key);
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+          lex_ = Lex::Number;
+          token_ = c;
+        } else if (c >= 'a' && c <= 'z') {
+          lex_ = Lex::Literal;
+          token_ = c;
+        } else if (c == '{' || c == '}' || c == '[' || c == ']' ||
+            c == ':' || c == ',') {
+          punct(c);
+        } else {
+          fail(std::string("unexpected character '") + c + "'");
+        }
+        break;
+
+      case Lex::String: {
+        if (high_surrogate_ != 0 && c != '\\') {
+          fail("unpaired UTF-16 surrogate");
+          break;
+        }
+        size_t j = i;
+        while (j < n && data[j] != '"' && data[j] != '\\' &&
+            static_cast<unsigned char>(data[j]) >= 0x20) {
+          ++j;
+        }
+        token_.append(data + i, j - i);
+        i = j;
+        if (i == n) {
+          break;
+        }
+        c = data[i++];
+        if (c == '"') {
+          lex_ = Lex::Ws;
+          finish_string();
+        } else if (c == '\\') {
+          lex_ = Lex::Escape;
+        } else {
+          fail("control character in string");
+        }
+        break;
+      }
+
+      case Lex::Escape:
+        ++i;
+        lex_ = Lex::String;
+        if (high_surrogate_ != 0 && c != 'u') {
+          fail("unpaired UTF-16 surrogate");
+          break;
+        }
+        switch (c) {
+          case '"': case '\\': case '/': token_ += c; break;
+          case 'b': token_ += '\b'; break;
+          case 'f': token_ += '\f'; break;
+          case 'n': token_ += '\n'; break;
+          case 'r': token_ += '\r'; break;
+          case 't': token_ += '\t'; break;
+          case 'u':
+            lex_ = Lex::Unicode;
+            unicode_ = 0;
+            unicode_digits_ = 0;
+            break;
+          default:
+            fail(std::string("bad escape '\\") + c + "'");
+        }
+        break;
+
+      case Lex::Unicode: {
+        ++i;
+        int h = hex_value(c);
+        if (h < 0) {
+          fail("bad \\u escape");
+          break;
+        }
+        unicode_ = unicode_ * 16 + h;
+        if (++unicode_digits_ < 4) {
+          break;
+        }
+        lex_ = Lex::String;
+        if (high_surrogate_ != 0) {
+          if (unicode_ < 0xDC00 || unicode_ > 0xDFFF) {
+            fail("unpaired UTF-16 surrogate");
+            break;
+          }
+          append_utf8(0x10000 + ((high_surrogate_ - 0xD800) << 10) +
+              (unicode_ - 0xDC00));
+          high_surrogate_ = 0;
+        } else if (unicode_ >= 0xD800 && unicode_ <= 0xDBFF) {
+          high_surrogate_ = unicode_;
+        } else if (unicode_ >= 0xDC00 && unicode_ <= 0xDFFF) {
+          fail("unpaired UTF-16 surrogate");
+        } else {
+          append_utf8(unicode_);
+        }
+        break;
+      }
+
+      case Lex::Number:
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' ||
+            c == '+' || c == '-') {
+          token_ += c;
+          ++i;
+        } else {
+          lex_ = Lex::Ws;
+          finish_number();
+        }
+        break;
+
+      case Lex::Literal:
+        if (c >= 'a' && c <= 'z') {
+          token_ += c;
+          ++i;
+        } else {
+          lex_ = Lex::Ws;
+          finish_literal();
+        }
+        break;
+    }
+  }
+}
+
+bool TrialOutputParser::finish()
+{
+  if (lex_ == Lex::Number) {
+    lex_ = Lex::Ws;
+    finish_number();
+  } else if (lex_ == Lex::Literal) {
+    lex_ = Lex::Ws;
+    finish_literal();
+  } else if (lex_ != Lex::Ws && lex_ != Lex::Done) {
+    fail("unterminated string");
+  }
+  if (lex_ != Lex::Done) {
+    fail("unexpected end of output");
+  }
+  return !failed();
+}
+
+} // namespace royale
@@ -0,0 +1,283 @@
+#include <royale/Zygote.hpp>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <boost/asio.hpp>
+#include <boost/process/extend.hpp>
+
+namespace royale {
+
+/// One trial in flight on a zygote: the runner's ends of the child's pipes,
+/// and what has been collected from them so far
+struct ZygoteJob
+{
+  io::posix::stream_descriptor in;
+  io::posix::stream_descriptor out;
+  io::posix::stream_descriptor err;
+  io::steady_timer timer;
+  std::string input;
+  std::shared_ptr<StreamCapture> outcap;
+  std::shared_ptr<StreamCapture> errcap;
+  int pid = -1;
+  bool expired = false; // the deadline passed, maybe before pid was known
+  int status = -1;
+  std::error_code ec;
+  int remaining = 4; // stdin written, stdout and stderr closed, status known
+  Zygote::handler_type handler;
+
+  ZygoteJob(io::io_context &ioc, const CaptureConfig &capture,
+      std::string input, Zygote::handler_type h)
+    : in(ioc), out(ioc), err(ioc), timer(ioc), input(std::move(input)),
+      outcap(std::make_shared<StreamCapture>(capture, "stdout")),
+      errcap(std::make_shared<StreamCapture>(capture, "stderr")),
+      handler(std::move(h)) {}
+
+  /// Kill the child's process group, once its pid is known
+  void kill(const std::string &name)
+  {
+    if (pid <= 0 || remaining == 0) {
+      return;
+    }
+    spdlog::get("log")->warn("Zygote child {} for \"{}\" timed out; "
+        "killing it", pid, name);
+    ec = std::make_error_code(std::errc::timed_out);
+    if (::kill(-pid, SIGKILL) < 0) {
+      ::kill(pid, SIGKILL);
+    }
+  }
+
+  void step()
+  {
+    if (--remaining > 0) {
+      return;
+    }
+    timer.cancel();
+    Zygote::files_type files;
+    if (outcap->spill_path() != "") {
+      files["stdout"] = outcap->spill_path();
+    }
+    if (errcap->spill_path() != "") {
+      files["stderr"] = errcap->spill_path();
+    }
+    handler(status, ec, outcap->str(), errcap->str(), std::move(files));
+  }
+};
+
+namespace {
+
+void make_pipe(int (&fds)[2])
+{
+  ROYALE_ERRNO_THROW(::pipe2, (fds, O_CLOEXEC));
+}
+
+void send_with_fds(int sock, const std::string &msg, const int *fds,
+    size_t nfds)
+{
+  std::vector<char> ctrl(CMSG_SPACE(sizeof(int) * nfds));
+
+  struct iovec iov;
+  iov.iov_base = const_cast<char *>(msg.data());
+  iov.iov_len = msg.size();
+
+  struct msghdr hdr = {};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = ctrl.data();
+  hdr.msg_controllen = ctrl.size();
+
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+
+  ROYALE_ERRNO_THROW(::sendmsg, (sock, &hdr, MSG_NOSIGNAL));
+}
+
+} // namespace
+
+Zygote::Zygote(io::io_context &ioc, const Experiment &exp,
+    const LaunchPlan &plan, CaptureConfig capture)
+  : ioc_(&ioc), name_(exp.name()), capture_(std::move(capture)),
+    control_(ioc)
+{
+  int fds[2];
+  ROYALE_ERRNO_THROW(::socketpair,
+      (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds));
+  control_.assign(io::generic::seq_packet_protocol(AF_UNIX, 0), fds[0]);
+
+  int child_fd = fds[1];
+  auto zplan = plan.with_env({
+      {"ROYALE_PROTOCOL", "zygote"},
+      {"ROYALE_CONTROL_FD", std::to_string(child_fd)},
+    });
+  child_ = std::make_unique<bp::child>(zplan.exe().string(),
+      bp::args(zplan.args()),
+      bp::std_in < bp::null,
+      bp::std_out > bp::null,
+      zplan.env_init(),
+      bp::start_dir(zplan.start_dir().string()),
+      bp::extend::on_exec_setup([child_fd](auto &) {
+          ::fcntl(child_fd, F_SETFD, 0);
+        }));
+  ::close(child_fd);
+
+  spdlog::get("log")->info("Started zygote {} for \"{}\"",
+      child_->id(), name_);
+}
+
+Zygote::~Zygote()
+{
+  boost::system::error_code ec;
+  control_.close(ec);
+}
+
+void Zygote::read_control()
+{
+  control_.async_receive(io::buffer(buf_), flags_,
+    [self = shared_from_this()]
+    (const boost::system::error_code &ec, size_t n) {
+      if (ec || n == 0) {
+        self->fail(ec ? ec : boost::system::error_code(io::error::eof));
+        return;
+      }
+      try {
+        self->handle_message(json::parse(
+              self->buf_.data(), self->buf_.data() + n));
+      } catch (const std::exception &e) {
+        spdlog::get("log")->error("Zygote for \"{}\" sent bad message: {}",
+            self->name_, e.what());
+      }
+      self->read_control();
+    });
+}
+
+void Zygote::handle_message(const json &msg)
+{
+  SPDLOG_DEBUG(spdlog::get("log"), "Zygote for \"{}\" sent {}",
+      name_, xtd::lazy_json_dump(msg));
+
+  if (msg.value("ready", false)) {
+    ready_ = true;
+    auto waiting = std::move(waiting_);
+    for (auto &f : waiting) {
+      f();
+    }
+    return;
+  }
+
+  auto i = pending_.find(msg.at("id").get<uint64_t>());
+  if (i == pending_.end()) {
+    return;
+  }
+
+  auto job = i->second;
+  auto pid = msg.find("pid");
+  if (pid != msg.end()) {
+    job->pid = *pid;
+    if (job->expired) {
+      job->kill(name_);
+    }
+  }
+  auto status = msg.find("status");
+  if (status != msg.end()) {
+    job->status = *status;
+    pending_.erase(i);
+    job->step();
+  }
+}
+
+void Zygote::fail(const std::error_code &ec)
+{
+  if (dead_) {
+    return;
+  }
+  dead_ = true;
+  spdlog::get("log")->error("Zygote for \"{}\" died: {}",
+      name_, ec.message());
+
+  auto pending = std::move(pending_);
+  for (auto &cur : pending) {
+    cur.second->ec = ec;
+    cur.second->step();
+  }
+
+  auto waiting = std::move(waiting_);
+  for (auto &f : waiting) {
+    f();
+  }
+}
+
+void Zygote::run(std::string input, double timeout, handler_type handler)
+{
+  if (!ready_ && !dead_) {
+    waiting_.emplace_back(
+      [self = shared_from_this(), input = std::move(input), timeout, handler]
+      () mutable {
+        self->run(std::move(input), timeout, std::move(handler));
+      });
+    return;
+  }
+
+  if (dead_) {
+    handler(-1, std::make_error_code(std::errc::broken_pipe), "", "", {});
+    return;
+  }
+
+  auto job = std::make_shared<ZygoteJob>(*ioc_, capture_,
+      std::move(input), std::move(handler));
+
+  int in[2], out[2], err[2];
+  make_pipe(in);
+  make_pipe(out);
+  make_pipe(err);
+  job->in.assign(in[1]);
+  job->out.assign(out[0]);
+  job->err.assign(err[0]);
+
+  uint64_t id = next_id_++;
+  int child_fds[3] = { in[0], out[1], err[1] };
+  try {
+    json req = {{"id", id}};
+    send_with_fds(control_.native_handle(), req.dump(), child_fds, 3);
+  } catch (...) {
+    for (int fd : child_fds) {
+      ::close(fd);
+    }
+    throw;
+  }
+  for (int fd : child_fds) {
+    ::close(fd);
+  }
+  pending_.emplace(id, job);
+
+  if (timeout > 0) {
+    job->timer.expires_after(xtd::to_duration(timeout));
+    job->timer.async_wait(
+      [job, name = name_](const boost::system::error_code &ec) {
+        if (ec) {
+          return;
+        }
+        // If the zygote hasn't said the child's pid yet, it's killed as
+        // soon as it does
+        job->expired = true;
+        job->kill(name);
+      });
+  }
+
+  io::async_write(job->in, io::buffer(job->input),
+    [job](const boost::system::error_code &, size_t) {
+      boost::system::error_code ec;
+      job->in.close(ec);
+      job->step();
+    });
+  // Each read's pipe shares ownership of its job
+  using stream_ptr = std::shared_ptr<io::posix::stream_descriptor>;
+  async_capture(stream_ptr(job, &job->out), job->outcap,
+      [job]() { job->step(); });
+  async_capture(stream_ptr(job, &job->err), job->errcap,
+      [job]() { job->step(); });
+}
+
+} // namespace royale
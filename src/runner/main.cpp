@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <csignal>
 #include <unistd.h>
 #include <iostream>
 #include <utility>
@@ -15,6 +16,11 @@ int main(int argc, char *argv[])
 {
   auto console = spdlog::stderr_color_mt("log");
   auto json_console = spdlog::stderr_color_mt("json");
+
+  // Executors may exit without reading all their input; report that as a
+  // write error rather than dying
+  std::signal(SIGPIPE, SIG_IGN);
+
   auto runner = handle_options(argc, argv);
 
   runner->run();
@@ -2,8 +2,13 @@
 #include <cstring>
 #include <unistd.h>
 #include <iostream>
+#include <algorithm>
 #include <utility>
 #include <vector>
+#include <thread>
+#include <limits>
+#include <map>
+#include <set>
 #include <experimental/filesystem>
 #include <boost/lexical_cast.hpp>
 #include <cxxopts.hpp>
@@ -62,10 +67,17 @@ static std::unique_ptr<Runner> handle_option_result(
     std::exit(0);
   }
 
+  if (result.count("plugin-host") > 0) {
+    std::exit(Plugin::host(result["plugin-host"].as<std::string>()));
+  }
+
   auto ret = std::make_unique<Runner>();
 
   ret->pretty = result["pretty"].as<int>();
 
+  int jobs = result["jobs"].as<int>();
+  ret->jobs = jobs > 0 ? jobs : std::max(std::thread::hardware_concurrency(), 1U);
+
   auto get_str = [&](const char *s) {
     return result.count(s) > 0 ?
       result[s].as<std::string>() :
@@ -79,31 +91,49 @@ static std::unique_ptr<Runner> handle_option_result(
   };
 
   ret->cd = get_str("cd");
+  ret->cgroup = get_str("cgroup");
+  ret->capture.limit = result["output-limit"].as<size_t>();
+  ret->capture.spill_dir = get_str("spill-dir");
+  ret->blob_min = result["blob-min"].as<size_t>();
+  ret->speculate = result["speculate"].as<double>();
+  if (result.count("memo") > 0) {
+    ret->memo = std::make_unique<MemoCache>(get_str("memo"),
+        result["memo-max"].as<uint64_t>());
+  }
+  if (result.count("blobs") > 0) {
+    ret->blobs = std::make_unique<BlobStore>(get_str("blobs"));
+    BlobStore::default_store(ret->blobs.get());
+  }
 
   if (ret->cd != "") {
     ROYALE_ERRNO_THROW(chdir, (ret->cd.c_str()));
   }
 
-  auto add_str = [&](const char *str) -> Experiment & {
+  // The experiment's cd must be final before it's added, since the runner
+  // resolves its command then
+  auto add_str = [&](const char *str, const std::string &dir = {})
+    -> Experiment & {
     auto j = json::parse(str);
     SPDLOG_TRACE(log, "Adding Experiment json: {}", j.dump());
-    return ret->add_experiment(j);
+    Experiment exp = j;
+    if (dir != "" && exp.cd() == "") {
+      exp.cd(dir);
+    }
+    return ret->add_experiment(std::move(exp));
   };
 
-  auto add_file = [&](const char *filename) -> Experiment & {
+  auto add_file = [&](const char *filename, const std::string &dir = {})
+    -> Experiment & {
     log->info("Adding Experiment file {}", filename);
     auto str = xtd::file_to_string(filename);
-    return add_str(str.c_str());
+    return add_str(str.c_str(), dir);
   };
 
   for (const auto &dir : get_vec("directory")) {
     SPDLOG_TRACE(log, "Adding experiments from directory: {}", dir);
     for (const auto &file : fs::directory_iterator(dir)) {
       if (xtd::ends_with(file.path().c_str(), experiment_json_extension)) {
-        auto &exp = add_file(file.path().c_str());
-        if (exp.cd() == "") {
-          exp.cd(dir);
-        }
+        add_file(file.path().c_str(), dir);
       } else {
         SPDLOG_TRACE(log, "Skipping non-Experiment file: {}", file.path());
       }
@@ -118,12 +148,326 @@ static std::unique_ptr<Runner> handle_option_result(
     add_str(literal.c_str());
   }
 
+  // With --test, each --exec experiment's trials are tested on their own
+  std::shared_ptr<std::map<std::string, SequentialTest>> tests;
+  if (result.count("test") > 0) {
+    tests = std::make_shared<std::map<std::string, SequentialTest>>();
+    for (const auto &run : get_vec("exec")) {
+      tests->emplace(run, SequentialTest(get_str("test"),
+            result["alpha"].as<double>(), result["beta"].as<double>(),
+            result["indifference"].as<double>()));
+    }
+  }
+
+  // With --estimate, each --exec experiment's trials are estimated on their
+  // own. All plan the same number of trials.
+  std::shared_ptr<std::map<std::string, IntervalEstimate>> estimates;
+  size_t planned = 0;
+  if (result.count("estimate") > 0) {
+    estimates = std::make_shared<std::map<std::string, IntervalEstimate>>();
+    for (const auto &run : get_vec("exec")) {
+      auto i = estimates->emplace(run, IntervalEstimate(get_vec("estimate"),
+            result["half-width"].as<double>(),
+            result["confidence"].as<double>(), get_str("interval"))).first;
+      planned = i->second.planned();
+    }
+  }
+
+  // With --ndjson, each trial is written as soon as it completes, rather
+  // than kept for one results array at the end
+  std::shared_ptr<NdjsonWriter> ndjson;
+  if (result.count("ndjson") > 0) {
+    if (result.count("analysis") > 0) {
+      log->error("--ndjson option can't be used with -A/--analysis option");
+      throw std::runtime_error("bad command line options");
+    }
+    ndjson = std::make_shared<NdjsonWriter>(ret->ioc(), std::cout);
+  }
+
+  // With --duration, trials are started until it passes, then those in
+  // flight are left to finish
+  std::shared_ptr<TimeBudget> budget;
+  if (result.count("duration") > 0) {
+    budget = std::make_shared<TimeBudget>(get_str("duration"));
+  }
+
+  bool batch = result.count("batch") > 0;
+
+  // With a test, estimate, or duration, -R/--repeat only caps the number of
+  // trials. An estimate alone needs no more than it planned.
+  size_t repeat = std::max(result["repeat"].as<int>(), 0);
+  if (result.count("repeat") == 0) {
+    if (tests || budget) {
+      repeat = std::numeric_limits<size_t>::max();
+    } else if (estimates) {
+      repeat = planned;
+    }
+  }
+
+  // Trials to run of each --exec experiment, where not repeat
+  std::map<std::string, size_t> counts;
+
+  // Trials completed by an earlier, interrupted run. Their inputs' random
+  // generators pick up where that run stopped, and new trials are appended
+  // to its journal.
+  auto resumed = std::make_shared<std::vector<Trial>>();
+  std::shared_ptr<Journal> journal;
+  if (result.count("resume") > 0) {
+    if (batch || result.count("enumerate") > 0) {
+      log->error("--resume option can't be used with -B/--batch or "
+          "--enumerate options");
+      throw std::runtime_error("bad command line options");
+    }
+    std::string path = get_str("resume");
+    *resumed = Journal::load(path);
+    std::map<std::string, std::set<size_t>> done;
+    for (const auto &trial : *resumed) {
+      done[trial.input().experiment_name()].insert(trial.input().seq());
+    }
+    for (const auto &run : get_vec("exec")) {
+      counts[run] = repeat - std::min(repeat, done[run].size());
+      ret->resume(run, done[run]);
+    }
+    journal = std::make_shared<Journal>(path);
+  } else if (result.count("journal") > 0) {
+    std::string path = get_str("journal");
+    std::error_code ec;
+    if (fs::exists(path, ec) && fs::file_size(path, ec) > 0) {
+      log->error("Journal {} already has trials; continue it with --resume",
+          path);
+      throw std::runtime_error("bad command line options");
+    }
+    journal = std::make_shared<Journal>(path);
+  }
+
+  // With --enumerate, each sample of each --exec experiment's inputs is run
+  // once, or -R/--repeat times, and exact probabilities are reported
+  size_t enumerate_max = result["enumerate-max"].as<size_t>();
+  std::shared_ptr<std::map<std::string, EnumerationSummary>> enumeration;
+  if (result.count("enumerate") > 0) {
+    if (batch) {
+      log->error("--enumerate option can't be used with -B/--batch option");
+      throw std::runtime_error("bad command line options");
+    }
+    size_t shard = 0;
+    size_t shards = 1;
+    std::string spec = get_str("shard");
+    size_t slash = spec.find('/');
+    try {
+      if (slash == spec.npos) {
+        throw std::invalid_argument(spec);
+      }
+      shard = std::stoul(spec.substr(0, slash));
+      shards = std::stoul(spec.substr(slash + 1));
+    } catch (const std::logic_error &) {
+      log->error("--shard expects K/N, like 0/4; got \"{}\"", spec);
+      throw std::runtime_error("bad command line options");
+    }
+    size_t each = result.count("repeat") > 0 ? repeat : 1;
+    enumeration =
+      std::make_shared<std::map<std::string, EnumerationSummary>>();
+    for (const auto &run : get_vec("exec")) {
+      std::shared_ptr<InputEnumeration> space = InputEnumeration::of(
+          ret->experiments().at(run)->inputs(), enumerate_max);
+      if (!space) {
+        log->error("Experiment \"{}\" has more than {} possible input "
+            "samples to enumerate", run, enumerate_max);
+        throw std::runtime_error("bad command line options");
+      }
+      enumeration->emplace(run,
+          EnumerationSummary(run, space->size(), shard, shards));
+      counts[run] = ret->enumerate(run, std::move(space), shard, shards) *
+        each;
+    }
+  } else {
+    for (const auto &run : get_vec("exec")) {
+      auto e = ret->experiments().find(run);
+      if (e == ret->experiments().end()) {
+        continue;
+      }
+      auto space = InputEnumeration::of(e->second->inputs(), enumerate_max);
+      if (space) {
+        log->info("Experiment \"{}\" has only {} possible input samples; "
+            "--enumerate would run each once, for exact probabilities",
+            run, space->size());
+      }
+    }
+  }
+
+  // With --split, each --exec experiment is run in stages of --effort
+  // trials, each stage starting from copies of the trajectories which
+  // reached the last of the --levels
+  std::shared_ptr<std::map<std::string, MultilevelSplitting>> splitting;
+  if (result.count("split") > 0) {
+    if (batch || result.count("enumerate") > 0 ||
+        result.count("resume") > 0) {
+      log->error("--split option can't be used with -B/--batch, "
+          "--enumerate, or --resume options");
+      throw std::runtime_error("bad command line options");
+    }
+    if (result.count("levels") == 0) {
+      log->error("--split option requires --levels option");
+      throw std::runtime_error("bad command line options");
+    }
+    splitting =
+      std::make_shared<std::map<std::string, MultilevelSplitting>>();
+    for (const auto &run : get_vec("exec")) {
+      splitting->emplace(run, MultilevelSplitting(
+            result["levels"].as<std::vector<double>>(),
+            result["effort"].as<size_t>()));
+    }
+  }
+
+  // With --active, each --exec experiment is run in rounds of --refit
+  // trials, sampled where the given predicates are least certain by a
+  // logistic regression fit to the trials before
+  std::shared_ptr<std::map<std::string, ActiveSampler>> active;
+  size_t refit = result["refit"].as<size_t>();
+  if (result.count("active") > 0) {
+    if (batch || result.count("enumerate") > 0 ||
+        result.count("resume") > 0 || splitting) {
+      log->error("--active option can't be used with -B/--batch, "
+          "--enumerate, --resume, or --split options");
+      throw std::runtime_error("bad command line options");
+    }
+    if (refit == 0) {
+      log->error("--refit must be positive");
+      throw std::runtime_error("bad command line options");
+    }
+    active = std::make_shared<std::map<std::string, ActiveSampler>>();
+    for (const auto &run : get_vec("exec")) {
+      if (!ret->experiments().at(run)->proposal().empty()) {
+        log->error("--active option can't be used with experiment \"{}\"'s "
+            "proposal", run);
+        throw std::runtime_error("bad command line options");
+      }
+      active->emplace(run, ActiveSampler(get_vec("active"),
+            result["pool"].as<size_t>()));
+    }
+  }
+
+  // With several --exec experiments, their trials run together, sharing
+  // the -J/--jobs slots by the weights given with --share, 1 by default
+  std::map<std::string, double> weights;
+  if (result.count("share") > 0) {
+    auto runs = get_vec("exec");
+    for (const auto &spec : get_vec("share")) {
+      size_t eq = spec.rfind('=');
+      std::string run = spec.substr(0, eq);
+      double weight = 0;
+      try {
+        if (eq == spec.npos) {
+          throw std::invalid_argument(spec);
+        }
+        weight = std::stod(spec.substr(eq + 1));
+      } catch (const std::logic_error &) {
+        log->error("--share expects NAME=WEIGHT, like sim=2; got \"{}\"",
+            spec);
+        throw std::runtime_error("bad command line options");
+      }
+      if (std::find(runs.begin(), runs.end(), run) == runs.end() ||
+          !(weight > 0)) {
+        log->error("--share \"{}\" must name an --exec experiment, with "
+            "a positive weight", spec);
+        throw std::runtime_error("bad command line options");
+      }
+      weights[run] = weight;
+    }
+  }
+
+  // The test counts trials alike, so it would decide about whichever
+  // distribution the inputs were drawn from, not the experiment's own
+  if (tests) {
+    bool proposal = false;
+    for (const auto &run : get_vec("exec")) {
+      auto e = ret->experiments().find(run);
+      proposal = proposal ||
+        (e != ret->experiments().end() && !e->second->proposal().empty());
+    }
+    if (proposal || enumeration || splitting || active) {
+      log->error("--test option can't be used with --enumerate, --split, "
+          "--active, or an experiment's proposal, whose trials aren't "
+          "drawn from the experiment's inputs");
+      throw std::runtime_error("bad command line options");
+    }
+  }
+
+  // With --allocate, a budget of trials is split among the --exec
+  // experiments, a round at a time, to narrow the widest interval of any of
+  // their predicates
+  std::shared_ptr<SampleAllocator> allocator;
+  size_t round = result["allocate-round"].as<size_t>();
+  if (result.count("allocate") > 0) {
+    if (result.count("enumerate") > 0 || result.count("resume") > 0 ||
+        splitting || active) {
+      log->error("--allocate option can't be used with --enumerate, "
+          "--resume, --split, or --active options");
+      throw std::runtime_error("bad command line options");
+    }
+    if (round == 0) {
+      log->error("--allocate-round must be positive");
+      throw std::runtime_error("bad command line options");
+    }
+    allocator = std::make_shared<SampleAllocator>(get_vec("exec"),
+        result["allocate"].as<size_t>(), result["confidence"].as<double>(),
+        get_str("interval"));
+  }
+
   auto use_results =
-    [&runner = *ret, analysis = get_str("analysis"), log]
+    [&runner = *ret, analysis = get_str("analysis"), log,
+     stats = result.count("stats") > 0, tests, estimates, ndjson, enumeration,
+     splitting, active, budget, allocator]
     (std::vector<Trial> results, io::yield_context yield)
     {
+      // The test, estimate, enumeration, splitting, active sampling,
+      // duration, and allocation results, if any
+      json summary = json::object();
+      if (tests) {
+        summary["test"] = *tests;
+      }
+      if (estimates) {
+        summary["estimate"] = *estimates;
+      }
+      if (enumeration) {
+        json jenumeration = json::array();
+        for (const auto &e : *enumeration) {
+          jenumeration.push_back(e.second);
+        }
+        summary["enumeration"] = std::move(jenumeration);
+      }
+      if (splitting) {
+        summary["splitting"] = *splitting;
+      }
+      if (active) {
+        summary["active"] = *active;
+      }
+      if (budget) {
+        summary["duration"] = *budget;
+      }
+      if (allocator) {
+        summary["allocation"] = *allocator;
+      }
+
       json jresults;
-      if (analysis == "") {
+      if (ndjson) {
+        // Any results not already streamed, such as from -i/--input, then
+        // the summary, if any, on a last line of its own
+        for (auto &trial : results) {
+          if (runner.blobs) {
+            trial.externalize(*runner.blobs, runner.blob_min);
+          }
+          ndjson->write(trial);
+        }
+        if (!summary.empty()) {
+          ndjson->write(summary);
+        }
+        ndjson->flush();
+      } else if (analysis == "") {
+        if (runner.blobs) {
+          for (auto &trial : results) {
+            trial.externalize(*runner.blobs, runner.blob_min);
+          }
+        }
         jresults = json(results);
       } else {
         SPDLOG_TRACE(log, "Instantiating analyzer {}", analysis);
@@ -135,34 +479,228 @@ static std::unique_ptr<Runner> handle_option_result(
             xtd::lazy_json_dump(analyzer));
         jresults = json(analyzer.status());
       }
-      std::cout << xtd::dump(jresults, runner.pretty) << std::endl;
+      if (!ndjson && !summary.empty()) {
+        summary["results"] = std::move(jresults);
+        jresults = std::move(summary);
+      }
+      if (!ndjson) {
+        std::cout << xtd::dump(jresults, runner.pretty) << std::endl;
+      }
+      if (stats) {
+        json jstats = {{"speculation", runner.speculation()}};
+        if (runner.memo) {
+          jstats["memo"] = runner.memo->stats();
+        }
+        std::cerr << xtd::dump(jstats, runner.pretty) << std::endl;
+      }
     };
 
-  bool batch = result.count("batch") > 0;
-
   auto make_experiment_runner =
-    [repeat = result["repeat"].as<int>(),
-     runs = get_vec("exec"), batch]
+    [repeat, runs = get_vec("exec"), batch, tests, estimates, ndjson, journal,
+     resumed, counts, enumeration, splitting, active, refit, weights, budget,
+     allocator, round]
     (Runner &runner, auto callback) {
       if (runs.size() > 0) {
         runner.spawn(
-          [repeat, runs = std::move(runs), &runner, callback, batch]
+          [repeat, runs = std::move(runs), &runner, callback, batch, tests,
+           estimates, ndjson, journal, resumed, counts, enumeration,
+           splitting, active, refit, weights, budget, allocator, round]
           (io::yield_context yield)
           {
             std::vector<Trial> results;
 
-            for (const auto &run : runs) {
-              for (int i = 0; i < repeat; ++i) {
-                if (batch) {
-                  auto trials = runner.run_batch(run, yield);
-                  results.insert(results.end(),
-                      std::make_move_iterator(trials.begin()),
-                      std::make_move_iterator(trials.end()));
+            // Stop once every experiment's test, if any, has decided and
+            // its estimate, if any, is done, or once the duration, if any,
+            // has passed
+            bool stops = tests || estimates || budget;
+            auto decided = [tests, estimates, budget]() {
+              if (budget && budget->expired()) {
+                return true;
+              }
+              if (tests) {
+                for (const auto &test : *tests) {
+                  if (!test.second.decided()) {
+                    return false;
+                  }
+                }
+              }
+              if (estimates) {
+                for (const auto &estimate : *estimates) {
+                  if (!estimate.second.done()) {
+                    return false;
+                  }
+                }
+              }
+              return tests || estimates;
+            };
+            auto keep_result =
+              [&results, &runner, tests, estimates, ndjson, enumeration]
+              (Trial trial) {
+                if (tests) {
+                  auto test = tests->find(trial.input().experiment_name());
+                  if (test != tests->end()) {
+                    test->second.add(trial);
+                  }
+                }
+                if (estimates) {
+                  auto estimate =
+                    estimates->find(trial.input().experiment_name());
+                  if (estimate != estimates->end()) {
+                    estimate->second.add(trial);
+                  }
+                }
+                if (enumeration) {
+                  auto summary =
+                    enumeration->find(trial.input().experiment_name());
+                  if (summary != enumeration->end()) {
+                    summary->second.add(trial);
+                  }
+                }
+                if (ndjson) {
+                  if (runner.blobs) {
+                    trial.externalize(*runner.blobs, runner.blob_min);
+                  }
+                  ndjson->write(trial);
                 } else {
-                  Trial trial = runner.run_trial(run, yield);
                   results.emplace_back(std::move(trial));
                 }
+              };
+            auto add_result =
+              [&keep_result, journal, budget, allocator](Trial trial) {
+              if (journal) {
+                journal->append(trial);
+              }
+              if (budget) {
+                budget->add(trial);
               }
+              if (allocator) {
+                allocator->add(trial);
+              }
+              keep_result(std::move(trial));
+            };
+
+            for (auto &trial : *resumed) {
+              keep_result(std::move(trial));
+            }
+            resumed->clear();
+
+            if (budget) {
+              budget->start();
+            }
+
+            // With --allocate, each round's trials go to the experiments
+            // with the widest intervals so far
+            Runner::shares_type shares;
+            while (allocator && !allocator->done() && !decided()) {
+              auto next = allocator->next(batch ? 1 : round);
+              if (next.empty()) {
+                break;
+              }
+              if (batch) {
+                auto trials = runner.run_batch(next.begin()->first, yield);
+                if (trials.empty()) {
+                  // No runner took the batch, so none ever will
+                  spdlog::get("log")->error("Batch of \"{}\" ran no "
+                      "trials; stopping with {} of the --allocate budget "
+                      "spent", next.begin()->first, allocator->spent());
+                  break;
+                }
+                for (auto &trial : trials) {
+                  add_result(std::move(trial));
+                }
+                continue;
+              }
+              for (const auto &count : next) {
+                auto &share = shares[count.first];
+                share.count = count.second;
+                auto weight = weights.find(count.first);
+                if (weight != weights.end()) {
+                  share.weight = weight->second;
+                }
+              }
+              runner.run_shared(shares, add_result, yield,
+                  stops ? std::function<bool()>(decided) : nullptr);
+              shares.clear();
+            }
+
+            // With --allocate, the allocator has run them all
+            const std::vector<std::string> none;
+            for (const auto &run : allocator ? none : runs) {
+              if (splitting && splitting->count(run) > 0) {
+                auto &levels = splitting->at(run);
+                const auto &e = *runner.experiments().at(run);
+                // The duration, if any, can cut a stage short
+                auto expired = [budget]() {
+                  return budget && budget->expired();
+                };
+                while (!levels.done()) {
+                  auto trials = levels.stage_trials(e);
+                  size_t n = trials.size();
+                  runner.queue(run, std::move(trials));
+                  runner.run_trials(run, n,
+                      [&levels, &add_result](Trial trial) {
+                        levels.add(trial);
+                        add_result(std::move(trial));
+                      }, yield,
+                      budget ? std::function<bool()>(expired) : nullptr);
+                  if (expired()) {
+                    levels.stop();
+                    spdlog::get("log")->warn("--duration passed before "
+                        "splitting \"{}\" reached its last level; its "
+                        "estimate is of level {} only", run,
+                        levels.level_probs().size());
+                    break;
+                  }
+                  levels.next_stage();
+                }
+              } else if (active && active->count(run) > 0) {
+                auto &sampler = active->at(run);
+                const auto &e = *runner.experiments().at(run);
+                auto count = counts.find(run);
+                size_t total = count != counts.end() ? count->second : repeat;
+                for (size_t done = 0; done < total && !decided();) {
+                  size_t n = std::min(refit, total - done);
+                  runner.queue(run, sampler.draw(e, n));
+                  runner.run_trials(run, n,
+                      [&sampler, &add_result](Trial trial) {
+                        sampler.add(trial);
+                        add_result(std::move(trial));
+                      }, yield,
+                      stops ? std::function<bool()>(decided) : nullptr);
+                  done += n;
+                  sampler.refit(yield);
+                }
+              } else if (batch) {
+                for (size_t i = 0; i < repeat && !decided(); ++i) {
+                  for (auto &trial : runner.run_batch(run, yield)) {
+                    add_result(std::move(trial));
+                  }
+                }
+              } else {
+                auto count = counts.find(run);
+                auto &share = shares[run];
+                share.count += count != counts.end() ? count->second : repeat;
+                auto weight = weights.find(run);
+                if (weight != weights.end()) {
+                  share.weight = weight->second;
+                }
+              }
+            }
+
+            // Trials of the rest run together, sharing the slots
+            if (!shares.empty()) {
+              runner.run_shared(shares, add_result, yield,
+                  stops ? std::function<bool()>(decided) : nullptr);
+            }
+
+            if (budget) {
+              budget->finish();
+              spdlog::get("log")->info(
+                  "Ran {} trials in {:.1f} s: {:.3g} per second",
+                  budget->trials(), budget->elapsed(), budget->throughput());
+            }
+            if (journal) {
+              journal->sync();
             }
 
             callback(std::move(results), yield);
@@ -243,6 +781,117 @@ std::unique_ptr<Runner> handle_options(int argc, char *argv[])
       cxxopts::value<std::vector<std::string>>())
     ("R,repeat", "Run all --exec experiments N times before exiting",
       cxxopts::value<int>()->default_value("1"))
+    ("J,jobs", "Run up to N local trials at once, shared among --exec "
+      "experiments. If 0, use the number of available cores",
+      cxxopts::value<int>()->default_value("1"))
+    ("cgroup", "Delegated cgroup v2 directory to create per-trial cgroups "
+      "in, for experiments' cpuset, memory_max, and cpu_weight",
+      cxxopts::value<std::string>())
+    ("output-limit", "Keep at most N bytes of each trial's stdout and stderr: "
+      "the first and last N/2. If 0, keep all output",
+      cxxopts::value<size_t>()->default_value("1048576"))
+    ("spill-dir", "Write whole stdout and stderr streams over --output-limit "
+      "to files in this directory, listed in each trial's \"files\"",
+      cxxopts::value<std::string>())
+    ("blobs", "Content-addressed blob directory. Stderr and aux values of "
+      "at least --blob-min bytes are written there once, and replaced by "
+      "their digests in results; -i/--input results load them from there",
+      cxxopts::value<std::string>())
+    ("blob-min", "Minimum size in bytes of text kept as a blob, in --blobs "
+      "and in -B/--batch results sent between runners",
+      cxxopts::value<size_t>()->default_value("64"))
+    ("memo", "Cache directory for trials of experiments with "
+      "\"deterministic\", so trials with the same sample and replicate are "
+      "only run once",
+      cxxopts::value<std::string>())
+    ("memo-max", "Maximum total bytes of --memo cache entries; the least "
+      "recently used are removed past this",
+      cxxopts::value<uint64_t>()->default_value("1073741824"))
+    ("plugin-host", "Internal: serve the persistent executor protocol with "
+      "the given plugin library, for experiments with \"isolate\"",
+      cxxopts::value<std::string>())
+    ("speculate", "Start a second copy of any local spawned trial running "
+      "past this percentile (0-100) of its experiment's recent run times, "
+      "keeping whichever finishes first. If 0, don't",
+      cxxopts::value<double>()->default_value("0"))
+    ("test", "Test a predicate's probability, like \"acute >= 0.3\", "
+      "with a sequential probability ratio test of each --exec experiment, "
+      "stopping once all have decided. "
+      "-R/--repeat then caps the trials run, and is unlimited by default",
+      cxxopts::value<std::string>())
+    ("alpha", "--test chance of deciding a property fails when it holds",
+      cxxopts::value<double>()->default_value("0.05"))
+    ("beta", "--test chance of deciding a property holds when it fails",
+      cxxopts::value<double>()->default_value("0.05"))
+    ("indifference", "--test half-width of the region around the bound in "
+      "which either decision is acceptable",
+      cxxopts::value<double>()->default_value("0.01"))
+    ("estimate", "Estimate the probability of the given predicates in each "
+      "--exec experiment with confidence intervals, stopping once all are "
+      "within --half-width. -R/--repeat then caps the trials run of each, "
+      "and defaults to the number planned by the Okamoto bound",
+      cxxopts::value<std::vector<std::string>>())
+    ("half-width", "--estimate target half-width of each interval",
+      cxxopts::value<double>()->default_value("0.01"))
+    ("confidence", "--estimate confidence level of each interval",
+      cxxopts::value<double>()->default_value("0.95"))
+    ("interval", "--estimate interval method: wilson or clopper-pearson",
+      cxxopts::value<std::string>()->default_value("wilson"))
+    ("ndjson", "Print each trial as one line of JSON as soon as it "
+      "completes, rather than all results at the end. Any --test or "
+      "--estimate follows on a last line")
+    ("journal", "Append each completed trial to this file, synced to disk "
+      "in groups, so an interrupted run can be continued with --resume",
+      cxxopts::value<std::string>())
+    ("resume", "Continue the run recorded in this --journal file: its "
+      "trials count towards -R/--repeat and are included in the results, "
+      "inputs are sampled from where it stopped, and new trials are "
+      "appended to it",
+      cxxopts::value<std::string>())
+    ("enumerate", "Run each possible sample of each --exec experiment's "
+      "inputs once (or -R/--repeat times), and report exact probabilities. "
+      "Inputs must all be constants, choices of constants, or small uniform "
+      "integer ranges")
+    ("shard", "With --enumerate, run only samples K, K + N, K + 2N, and so "
+      "on, given as K/N",
+      cxxopts::value<std::string>()->default_value("0/1"))
+    ("enumerate-max", "Most possible input samples an experiment may have "
+      "for --enumerate",
+      cxxopts::value<size_t>()->default_value("1000000"))
+    ("split", "Estimate the probability of each --exec experiment's "
+      "trajectories reaching the last of --levels by multilevel splitting, "
+      "in stages of --effort trials. Executors must report a progress score "
+      "through the replicate fields")
+    ("levels", "--split increasing levels of progress score",
+      cxxopts::value<std::vector<double>>())
+    ("effort", "--split trials run at each level",
+      cxxopts::value<size_t>()->default_value("1000"))
+    ("active", "Sample each --exec experiment's inputs where the given "
+      "predicates are least certain, by a logistic regression refit every "
+      "--refit trials, rather than from their specs alone",
+      cxxopts::value<std::vector<std::string>>())
+    ("refit", "--active trials between fits",
+      cxxopts::value<size_t>()->default_value("100"))
+    ("pool", "--active candidate samples to pick each trial's sample from",
+      cxxopts::value<size_t>()->default_value("64"))
+    ("share", "Weight of an --exec experiment's share of the -J/--jobs "
+      "slots, given as NAME=WEIGHT; 1 by default. Several experiments' "
+      "trials run together, each getting slots by its weight",
+      cxxopts::value<std::vector<std::string>>())
+    ("duration", "Start trials until this long has passed, in seconds, or "
+      "minutes or hours like 30m or 2h, then wait for those running to "
+      "finish. -R/--repeat then only caps the trials run. With -B/--batch, "
+      "no more batches are started once it has passed",
+      cxxopts::value<std::string>())
+    ("allocate", "Split a budget of this many trials among the --exec "
+      "experiments, a round at a time, to whichever have the widest "
+      "--confidence intervals of any of their predicates, rather than "
+      "running each -R/--repeat times. With -B/--batch, each batch goes to "
+      "one experiment",
+      cxxopts::value<size_t>())
+    ("allocate-round", "--allocate trials to hand out between updates",
+      cxxopts::value<size_t>()->default_value("100"))
+    ("stats", "After the results, print runner statistics as JSON to stderr")
     ("s,serve", "Listen for HTTP requests on given ip:port. "
       "Default ip is 127.0.0.1",
       cxxopts::value<std::string>())
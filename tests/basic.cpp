@@ -1,6 +1,9 @@
 #define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
 
+#include <random>
+#include <thread>
+
 #include "royale/Runner.hpp"
 
 using namespace royale;
@@ -102,6 +105,30 @@ TEST_CASE("Experiment", "[experiment]") {
     CHECK(env.at("C") == "3");
   }
 
+  SECTION("Check launch plan") {
+    LaunchPlan plan(exp);
+    CHECK(plan.exe().is_absolute());
+    CHECK(plan.exe().filename() == "ls");
+    CHECK(plan.start_dir().is_absolute());
+
+    const auto &args = plan.args();
+    REQUIRE(args.size() == 2);
+    CHECK(args.at(0) == "-alh");
+    CHECK(args.at(1) == "/");
+
+    std::vector<std::string> envp;
+    for (auto cur = plan.envp(); *cur; ++cur) {
+      envp.emplace_back(*cur);
+    }
+    CHECK(std::count(envp.begin(), envp.end(), "PATH=/bin:/usr/bin") == 1);
+    CHECK(std::count(envp.begin(), envp.end(), "ROOT=/") == 1);
+    CHECK(std::count(envp.begin(), envp.end(), "A=1") == 1);
+
+    auto plan2 = plan.with_env({{"A", "4"}});
+    CHECK(plan2.vars().at("A") == "4");
+    CHECK(plan.vars().at("A") == "1");
+  }
+
   SECTION("Check inputs map") {
     const auto &i = exp.inputs().inputs();
     REQUIRE(i.size() == 17);
@@ -158,6 +185,673 @@ TEST_CASE("Experiment", "[experiment]") {
   }
 }
 
+// Hidden: run with "bin/tests/basic [benchmark]". Compares launching a
+// trial's executor from its LaunchPlan with resolving the command for each
+// trial, as the runner did before plans: search the runner's PATH and the
+// experiment's directory, then spawn with the inherited environment.
+TEST_CASE("LaunchPlan launch time", "[.][benchmark]") {
+  const int launches = 500;
+
+  Experiment exp;
+  exp.name("bench").cmd("true");
+  LaunchPlan plan(exp);
+  REQUIRE(!plan.exe().empty());
+
+  using clock = std::chrono::steady_clock;
+  auto ms_per_launch = [](clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count() / launches;
+  };
+
+  auto start = clock::now();
+  for (int i = 0; i < launches; ++i) {
+    auto path = boost::this_process::path();
+    path.push_back(boost::filesystem::current_path() / exp.cd());
+    auto exe = bp::search_path(exp.cmd().at(0), std::move(path));
+    bp::child child(exe.string(), bp::args(plan.args()),
+        bp::start_dir(exp.cd()));
+    child.wait();
+  }
+  auto searched = clock::now() - start;
+
+  start = clock::now();
+  for (int i = 0; i < launches; ++i) {
+    bp::child child(plan.exe().string(), bp::args(plan.args()),
+        plan.env_init(), bp::start_dir(plan.start_dir().string()));
+    child.wait();
+  }
+  auto planned = clock::now() - start;
+
+  start = clock::now();
+  for (int i = 0; i < launches; ++i) {
+    auto path = boost::this_process::path();
+    path.push_back(boost::filesystem::current_path() / exp.cd());
+    CHECK(bp::search_path(exp.cmd().at(0), std::move(path)) == plan.exe());
+  }
+  auto resolved = clock::now() - start;
+
+  std::cout << "ms per launch of \"true\" over " << launches << " launches:\n"
+    << "  search_path each launch: " << ms_per_launch(searched) << "\n"
+    << "  LaunchPlan:              " << ms_per_launch(planned) << "\n"
+    << "  search_path alone:       " << ms_per_launch(resolved) << "\n";
+}
+
+TEST_CASE("CpuAllocator", "[resources]") {
+  SECTION("Check CPU lists") {
+    CHECK(parse_cpu_list("0-3,8\n") == CpuSet({0, 1, 2, 3, 8}));
+    CHECK(parse_cpu_list("") == CpuSet());
+    CHECK_THROWS(parse_cpu_list("a-b"));
+    CHECK(format_cpu_list({0, 1, 2, 3, 8, 10, 11}) == "0-3,8,10-11");
+    CHECK(format_cpu_list({}) == "");
+  }
+
+  CpuAllocator alloc({{0, 1, 2, 3}, {4, 5, 6, 7}});
+
+  SECTION("Check NUMA packing") {
+    auto a = alloc.acquire(2);
+    CHECK(a == CpuSet({0, 1}));
+
+    // Fullest node with room is preferred
+    auto b = alloc.acquire(2);
+    CHECK(b == CpuSet({2, 3}));
+
+    auto c = alloc.acquire(3);
+    CHECK(c == CpuSet({4, 5, 6}));
+
+    alloc.release(a);
+    auto d = alloc.acquire(1);
+    CHECK(d == CpuSet({7}));
+
+    // No node has 3 free, but 3 are free in total
+    alloc.release(d);
+    auto e = alloc.acquire(3);
+    CHECK(e == CpuSet({0, 1, 7}));
+
+    CHECK(alloc.acquire(1).empty());
+  }
+
+  SECTION("Check allowed CPUs") {
+    auto a = alloc.acquire(2, {3, 4, 5});
+    CHECK(a == CpuSet({4, 5}));
+    CHECK(alloc.acquire(2, {3, 4, 5}).empty());
+  }
+}
+
+TEST_CASE("StreamCapture", "[capture]") {
+  CaptureConfig config;
+  config.limit = 8;
+
+  SECTION("Check short stream") {
+    StreamCapture cap(config, "stdout");
+    cap.append("abc", 3);
+    cap.append("defgh", 5);
+    CHECK(!cap.truncated());
+    CHECK(cap.str() == "abcdefgh");
+  }
+
+  SECTION("Check head and tail") {
+    StreamCapture cap(config, "stdout");
+    cap.append("abcdef", 6);
+    cap.append("ghij", 4);
+    cap.append("klm", 3);
+    CHECK(cap.total() == 13);
+    CHECK(cap.truncated());
+    CHECK(cap.str() == "abcd\n[... 5 bytes omitted ...]\njklm");
+    CHECK(cap.spill_path() == "");
+
+    CHECK(cap.take() == "abcd\n[... 5 bytes omitted ...]\njklm");
+    CHECK(cap.total() == 0);
+    CHECK(cap.str() == "");
+  }
+
+  SECTION("Check unlimited") {
+    config.limit = 0;
+    StreamCapture cap(config, "stdout");
+    cap.append("abcdefghijklm", 13);
+    CHECK(!cap.truncated());
+    CHECK(cap.str() == "abcdefghijklm");
+  }
+}
+
+TEST_CASE("TrialOutputParser", "[parser]") {
+  auto parse = [](const std::string &s, size_t chunk) {
+    auto p = std::make_shared<TrialOutputParser>();
+    for (size_t i = 0; i < s.size(); i += chunk) {
+      p->feed(s.data() + i, std::min(chunk, s.size() - i));
+    }
+    p->finish();
+    return p;
+  };
+
+  SECTION("Check valid output in any chunk size") {
+    std::string s = R"({"preds": {"acute": true, "right": false},)"
+      R"( "aux": {"x": 1.5, "y": [1, {"z": null}], "s": "a\"\né😀"},)"
+      R"( "replicate": {"k": -3e2}, "other": [[]]})" "\n";
+    TrialOutput expected = json::parse(s);
+
+    for (size_t chunk : {1, 2, 7, 4096}) {
+      auto p = parse(s, chunk);
+      REQUIRE(!p->failed());
+      CHECK(json(p->output()) == json(expected));
+    }
+  }
+
+  SECTION("Check bad output") {
+    for (const char *s : {"", "[1]", R"({"preds": {"a": 1}})",
+        R"({"aux": []})", R"({"a": 1,})", R"({"aux": {"n": 01}})",
+        R"({"aux": {"s": "\ud83d"}})", R"({} x)", R"({"aux": {"t": tru}})"}) {
+      CHECK(parse(s, 1)->failed());
+    }
+  }
+
+  SECTION("Check invalid UTF-8") {
+    for (const char *s : {"{\"aux\": {\"s\": \"\xff\"}}",
+        "{\"replicate\": \"caf\xe9\"}", "{\"aux\": {\"\xc3\": 1}}",
+        "{\"aux\": {\"s\": \"\xed\xa0\x80\"}}",
+        "{\"aux\": {\"s\": \"\xc0\xaf\"}}"}) {
+      for (size_t chunk : {1, 4096}) {
+        CHECK(parse(s, chunk)->failed());
+      }
+    }
+    CHECK(!parse("{\"aux\": {\"s\": \"\xc3\xa9\"}}", 1)->failed());
+  }
+
+  SECTION("Check reserved aux keys") {
+    const char *s = R"({"aux": {"a": {"$blob": "0"}}})";
+    CHECK(parse(s, 1)->failed());
+    CHECK(!parse(R"({"aux": {"a": {"b": {"$blob": "0"}}}})", 1)->failed());
+    TrialOutput out = json::parse(s);
+    CHECK_THROWS(out.check_aux());
+  }
+}
+
+TEST_CASE("BlobStore", "[blob]") {
+  BlobStore store;
+
+  SECTION("Check digests") {
+    CHECK(BlobStore::digest("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    CHECK(BlobStore::digest(std::string(64, 'x')) ==
+        "bb2fa3ee7afb9f54c6dfb5d021f14b1ffe40c163");
+    auto d = store.put("warning: foo\n");
+    CHECK(store.put("warning: foo\n") == d);
+    CHECK(store.blobs().size() == 1);
+    CHECK(store.get(d) == "warning: foo\n");
+    CHECK_THROWS(store.get("0"));
+  }
+
+  SECTION("Check trial round-trip") {
+    TrialOutput out = json::parse(
+        R"({"preds": {"a": true}, "aux": {"big": [1, 2, 3], "n": 1}})");
+    Trial t1("test"), t2("test");
+    t1.status(TrialStatus::Complete::mk(out, "warning: foo\n"));
+    t2.status(TrialStatus::Complete::mk(out, "warning: foo\n"));
+    t1.externalize(store, 5);
+    t2.externalize(store, 5);
+    CHECK(store.blobs().size() == 2);
+
+    auto j = json(t1);
+    CHECK(j["status"]["Complete"]["stderr"].is_object());
+    CHECK(j["status"]["Complete"]["output"]["aux"]["big"].is_object());
+    CHECK(j["status"]["Complete"]["output"]["aux"]["n"] == 1);
+
+    Trial t3 = j;
+    BlobStore::default_store(&store);
+    t3.status().visit(xtd::overload(
+      [](const TrialStatus::Complete &c) {
+        CHECK(c.stderr().text() == "warning: foo\n");
+        CHECK(c.output().aux("big") == json({1, 2, 3}));
+      },
+      [](const TrialStatus &) { FAIL("Not complete"); }));
+    BlobStore::default_store(nullptr);
+
+    t3.internalize(store);
+    t2.internalize(store);
+    CHECK(json(t3) == json(t2));
+    CHECK(json(t2)["status"]["Complete"]["stderr"] == "warning: foo\n");
+  }
+}
+
+TEST_CASE("RuntimeStats", "[speculate]") {
+  RuntimeStats stats(10);
+  CHECK(stats.percentile(95) == 0);
+
+  for (int i = 1; i <= 10; ++i) {
+    stats.add(i);
+  }
+  CHECK(stats.count() == 10);
+  CHECK(stats.percentile(50) == 5);
+  CHECK(stats.percentile(95) == 10);
+  CHECK(stats.percentile(0) == 1);
+
+  // Oldest run times make way for new ones
+  for (int i = 0; i < 5; ++i) {
+    stats.add(100);
+  }
+  CHECK(stats.count() == 10);
+  CHECK(stats.percentile(50) == 10);
+  CHECK(stats.percentile(10) == 6);
+}
+
+TEST_CASE("SequentialTest", "[sprt]") {
+  SECTION("Check parsing") {
+    SequentialTest t(" acute>=0.3 ", 0.05, 0.05, 0.01);
+    CHECK(t.pred() == "acute");
+    CHECK(t.op() == ">=");
+    CHECK(t.bound() == Approx(0.3));
+    CHECK(!t.decided());
+
+    CHECK_THROWS(SequentialTest("acute > 0.3", 0.05, 0.05, 0.01));
+    CHECK_THROWS(SequentialTest("acute >= x", 0.05, 0.05, 0.01));
+    CHECK_THROWS(SequentialTest("acute >= 0.995", 0.05, 0.05, 0.01));
+    CHECK_THROWS(SequentialTest("acute >= 0.3", 0, 0.05, 0.01));
+  }
+
+  SECTION("Check early decisions") {
+    SequentialTest holds("x >= 0.5", 0.05, 0.05, 0.1);
+    size_t n = 0;
+    while (!holds.add(true)) {
+      ++n;
+    }
+    CHECK(holds.decision() == "holds");
+    CHECK(n < 10);
+
+    SequentialTest fails("x <= 0.5", 0.05, 0.05, 0.1);
+    while (!fails.add(true)) {}
+    CHECK(fails.decision() == "fails");
+    CHECK(fails.output().sat_count() == fails.output().count());
+  }
+
+  SECTION("Check trials without the predicate") {
+    SequentialTest t("x >= 0.5", 0.05, 0.05, 0.1);
+    Trial trial("test");
+    trial.status(TrialStatus::Complete::mk(TrialOutput{}));
+    t.add(trial);
+    CHECK(t.output().error_count() == 1);
+    CHECK(t.llr() == 0);
+  }
+}
+
+TEST_CASE("IntervalEstimate", "[estimate]") {
+  SECTION("Check intervals") {
+    auto wilson = wilson_interval(5, 10, 0.95);
+    CHECK(wilson.first == Approx(0.2366).epsilon(0.001));
+    CHECK(wilson.second == Approx(0.7634).epsilon(0.001));
+
+    auto exact = clopper_pearson_interval(5, 10, 0.95);
+    CHECK(exact.first == Approx(0.1871).epsilon(0.001));
+    CHECK(exact.second == Approx(0.8129).epsilon(0.001));
+
+    CHECK(clopper_pearson_interval(0, 10, 0.95).first == 0);
+    CHECK(wilson_interval(0, 0, 0.95).second == 1);
+
+    CHECK(okamoto_trials(0.01, 0.99) == 26492);
+  }
+
+  SECTION("Check stopping") {
+    IntervalEstimate estimate({"x"}, 0.05, 0.95);
+    CHECK_THROWS(IntervalEstimate({"x"}, 0.05, 0.95, "normal"));
+    CHECK(!estimate.done());
+
+    size_t n = 0;
+    bool done = false;
+    while (!done) {
+      Trial trial("test");
+      TrialOutput output;
+      output.preds()["x"] = n % 2 == 0;
+      trial.status(TrialStatus::Complete::mk(std::move(output)));
+      done = estimate.add(trial);
+      ++n;
+    }
+    const auto &x = estimate.preds().at("x");
+    CHECK(x.half_width() <= 0.05);
+    CHECK(x.lower() < 0.5);
+    CHECK(x.upper() > 0.5);
+    CHECK(x.rel_error() == Approx(x.half_width() / x.prob()));
+    CHECK(n <= estimate.planned());
+  }
+}
+
+TEST_CASE("NdjsonWriter", "[ndjson]") {
+  io::io_context ioc;
+  std::ostringstream out;
+  {
+    NdjsonWriter writer(ioc, out, 32);
+
+    // Held until the delay passes
+    writer.write(json{{"a", 1}});
+    CHECK(out.str() == "");
+    ioc.run();
+    CHECK(out.str() == "{\"a\":1}\n");
+
+    // Or until the buffer fills
+    for (int i = 0; i < 4; ++i) {
+      writer.write(json{{"b", i}});
+    }
+    CHECK(out.str().size() == 8 + 4 * 8);
+
+    writer.write(json{{"c", 0}});
+  }
+  CHECK(out.str().size() == 8 + 5 * 8);
+}
+
+TEST_CASE("Journal", "[journal]") {
+  std::string path = "/tmp/royale-test-" + std::to_string(::getpid()) +
+    ".journal";
+  {
+    Journal journal(path, 2);
+    for (size_t i = 0; i < 3; ++i) {
+      Trial trial("test");
+      trial.input().seq(i);
+      journal.append(trial);
+    }
+  }
+
+  // As if killed partway through a line
+  {
+    std::ofstream out(path, std::ios::app);
+    out << "{\"input\":";
+  }
+  auto trials = Journal::load(path);
+  REQUIRE(trials.size() == 3);
+  CHECK(trials[2].input().seq() == 2);
+
+  {
+    Journal journal(path);
+    Trial trial("test");
+    trial.input().seq(3);
+    journal.append(trial);
+  }
+  trials = Journal::load(path);
+  REQUIRE(trials.size() == 4);
+  CHECK(trials[3].input().seq() == 3);
+
+  ::unlink(path.c_str());
+}
+
+TEST_CASE("MemoCache", "[memo]") {
+  std::string dir = "/tmp/royale-test-memo-" + std::to_string(::getpid());
+  Experiment exp;
+  exp.name("test").version("1");
+
+  TrialOutput output;
+  output.preds()["x"] = true;
+  TrialStatus::Enum status = TrialStatus::Complete::mk(std::move(output));
+  size_t size = json(status).dump().size();
+
+  auto key = [&](double a) {
+    return MemoCache::key(exp, TrialInput("test", {{"a", Value(a)}}));
+  };
+  CHECK(key(1) == key(1));
+  CHECK(key(1) != key(2));
+
+  {
+    // Room for two entries
+    MemoCache memo(dir, size * 2);
+    TrialStatus::Enum found;
+    CHECK(!memo.get(key(0), found));
+    memo.put(key(0), status);
+    memo.put(key(1), status);
+    CHECK(memo.get(key(0), found));
+    CHECK(json(found) == json(status));
+
+    // Evicts key(1), used least recently
+    memo.put(key(2), status);
+    CHECK(memo.size() == 2);
+    CHECK(!memo.get(key(1), found));
+    CHECK(memo.get(key(2), found));
+
+    CHECK(memo.stats().lookups() == 4);
+    CHECK(memo.stats().hits() == 2);
+    CHECK(memo.stats().hit_rate() == Approx(0.5));
+  }
+
+  // Entries outlive the cache
+  MemoCache memo(dir, size * 2);
+  CHECK(memo.size() == 2);
+
+  boost::filesystem::remove_all(dir);
+}
+
+TEST_CASE("InputEnumeration", "[enumerate]") {
+  SECTION("Check finite spaces") {
+    InputSpec spec = json::parse(
+        R"({"a": [1, [2, 3]], "b": {"UniformInt": {"range": [0, 2]}}})");
+    auto space = InputEnumeration::of(spec, 100);
+    REQUIRE(space);
+    CHECK(space->size() == 9);
+
+    double total = 0;
+    for (size_t i = 0; i < space->size(); ++i) {
+      total += space->at(i).second;
+    }
+    CHECK(total == Approx(1));
+
+    // "a" is 1 half the time, and 2 or 3 a quarter of the time each
+    auto first = space->at(0);
+    CHECK(xtd::dbl(first.first.at("a")) == 1);
+    CHECK(first.second == Approx(1.0 / 6));
+    CHECK(space->at(8).second == Approx(1.0 / 12));
+
+    CHECK(!InputEnumeration::of(spec, 8));
+  }
+
+  SECTION("Check infinite spaces") {
+    InputSpec spec = json::parse(R"({"a": [0, 1], "b": [[0, 1]]})");
+    CHECK(!InputEnumeration::of(spec, 100));
+  }
+
+  SECTION("Check exact probabilities") {
+    EnumerationSummary summary("test", 2, 0, 1);
+    for (int i = 0; i < 2; ++i) {
+      Trial trial("test");
+      trial.input().weight(i == 0 ? 1.5 : 0.5);
+      TrialOutput output;
+      output.preds()["x"] = i == 0;
+      trial.status(TrialStatus::Complete::mk(std::move(output)));
+      summary.add(trial);
+    }
+    CHECK(summary.preds().at("x").prob() == Approx(0.75));
+    CHECK(summary.preds().at("x").mass() == Approx(1));
+  }
+}
+
+TEST_CASE("Importance sampling", "[weights]") {
+  SECTION("Check densities") {
+    ValueSpec::Enum uniform = json::parse(R"({"Uniform": [0, 4]})");
+    CHECK(uniform->density(Value(1.0)) == Approx(0.25));
+    CHECK(uniform->density(Value(5.0)) == 0);
+
+    ValueSpec::Enum choose = json::parse(R"([1, [2, 3]])");
+    CHECK(choose->density(Value(1.0)) == Approx(0.5));
+    CHECK(choose->density(Value(3.0)) == Approx(0.25));
+  }
+
+  SECTION("Check likelihood ratios") {
+    InputSpec spec = json::parse(
+        R"({"x": {"Uniform": [0, 1]}, "k": [1, 2]})");
+    InputSpec::input_type proposal = json::parse(
+        R"({"x": {"Uniform": [0.9, 1]}})");
+    for (int i = 0; i < 10; ++i) {
+      auto sample = spec.sample(proposal);
+      CHECK(xtd::dbl(sample.first.at("x")) >= 0.9);
+      CHECK(sample.first.count("k") == 1);
+      CHECK(sample.second == Approx(0.1));
+    }
+  }
+
+  SECTION("Check weighted counts") {
+    PredicateOutput output;
+    output.add_unsat();
+    CHECK(!output.weighted());
+    output.add_sat(0.01);
+    output.add_unsat(0.01);
+    output.add_sat(0.01);
+    CHECK(output.weighted());
+    CHECK(output.sat_count() == 2);
+    CHECK(output.prob() == Approx(0.005));
+
+    output.interval("wilson", 0.95);
+    CHECK(output.lower() < 0.005);
+    CHECK(output.upper() > 0.005);
+    CHECK(output.rel_error() > 0);
+  }
+}
+
+TEST_CASE("MultilevelSplitting", "[split]") {
+  Experiment exp;
+  exp.name("walk");
+  exp.extend_inputs()
+      ("x", ValueSpec::Uniform::mk())
+    ;
+
+  CHECK_THROWS(MultilevelSplitting({2, 1}, 10));
+  CHECK_THROWS(MultilevelSplitting({1, 2}, 0));
+
+  // Each run reaches its level half the time, from wherever its state says
+  // the trajectory got to, so the top of three levels is reached an eighth
+  // of the time
+  MultilevelSplitting levels({1, 2, 3}, 1000, 0);
+  std::mt19937 random(0);
+  std::bernoulli_distribution coin(0.5);
+  std::set<double> starts;
+  while (!levels.done()) {
+    auto trials = levels.stage_trials(exp);
+    CHECK(trials.size() == 1000);
+    for (auto &trial : trials) {
+      const json &rep = trial.input().replicate();
+      double level = rep.at("level");
+      double from = rep.at("state").is_null() ? 0 : (double)rep.at("state");
+      CHECK(from == level - 1);
+      if (levels.stage() > 0) {
+        starts.insert(xtd::dbl(trial.sample().at("x")));
+      }
+
+      TrialOutput output;
+      if (coin(random)) {
+        output.replicate() = {{"score", level}, {"state", level}};
+      } else {
+        output.replicate() = {{"score", from}, {"state", nullptr}};
+      }
+      trial.status(TrialStatus::Complete::mk(std::move(output)));
+      levels.add(trial);
+    }
+    levels.next_stage();
+  }
+
+  // Later stages only start from samples which reached the first level
+  CHECK(starts.size() == levels.hits().at(0));
+  CHECK(levels.level_probs().size() == 3);
+  CHECK(levels.level_probs().at(0) == Approx(0.5).epsilon(0.2));
+  CHECK(levels.prob() == Approx(0.125).epsilon(0.2));
+  CHECK(levels.rel_error() > 0);
+  CHECK(levels.rel_error() < 0.2);
+  CHECK(!levels.stopped());
+
+  MultilevelSplitting cut({1, 2}, 10, 0);
+  cut.stage_trials(exp);
+  cut.stop();
+  CHECK(cut.stopped());
+  CHECK(cut.done());
+}
+
+TEST_CASE("ActiveSampler", "[active]") {
+  Experiment exp;
+  exp.name("edge");
+  exp.extend_inputs()
+      ("x", ValueSpec::Uniform::mk())
+    ;
+
+  CHECK_THROWS(ActiveSampler(ActiveSampler::preds_type{}));
+  CHECK_THROWS(ActiveSampler({"fail"}, 0));
+
+  ActiveSampler sampler({"fail"}, 64, 0.1, 0);
+  TrialInput::sample_type edge = json::parse(R"({"x": 0.5})");
+  TrialInput::sample_type inside = json::parse(R"({"x": 0.1})");
+  CHECK(sampler.uncertainty(inside) == 1);
+  CHECK(sampler.draw(exp, 1).at(0).input().weight() == 1);
+
+  // Fails above x = 0.5, and the fit is sure of it by 0.1 away
+  sampler.fits({{"fail", {{"", -50}, {"x", 100}}}});
+  CHECK(sampler.uncertainty(edge) == Approx(1));
+  CHECK(sampler.uncertainty(inside) < 1e-10);
+
+  size_t near = 0;
+  double weights = 0;
+  double sat_weights = 0;
+  auto trials = sampler.draw(exp, 2000);
+  for (const auto &trial : trials) {
+    double x = xtd::dbl(trial.sample().at("x"));
+    near += std::abs(x - 0.5) < 0.05;
+    weights += trial.input().weight();
+    if (x > 0.5) {
+      sat_weights += trial.input().weight();
+    }
+  }
+  CHECK(near > 1000);
+  CHECK(weights / 2000 == Approx(1).epsilon(0.1));
+  CHECK(sat_weights / 2000 == Approx(0.5).epsilon(0.1));
+}
+
+TEST_CASE("TimeBudget", "[duration]") {
+  CHECK(TimeBudget("90").seconds() == 90);
+  CHECK(TimeBudget("1.5s").seconds() == 1.5);
+  CHECK(TimeBudget("30m").seconds() == 1800);
+  CHECK(TimeBudget("2h").seconds() == 7200);
+  CHECK_THROWS(TimeBudget(""));
+  CHECK_THROWS(TimeBudget("m"));
+  CHECK_THROWS(TimeBudget("10 min"));
+  CHECK_THROWS(TimeBudget("0"));
+
+  TimeBudget budget("0.05");
+  CHECK(!budget.expired());
+  budget.start();
+  CHECK(!budget.expired());
+  budget.add(Trial("test"));
+  budget.add(Trial("test"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  CHECK(budget.expired());
+  budget.finish();
+  CHECK(budget.trials() == 2);
+  CHECK(budget.elapsed() >= 0.05);
+  CHECK(budget.throughput() == Approx(2 / budget.elapsed()));
+}
+
+TEST_CASE("SampleAllocator", "[allocate]") {
+  CHECK_THROWS(SampleAllocator({}, 100));
+  CHECK_THROWS(SampleAllocator({"a"}, 100, 0.95, "bogus"));
+
+  // Untried experiments share the first round evenly
+  SampleAllocator alloc({"even", "rare", "likely"}, 3000, 0.95);
+  auto first = alloc.next(30);
+  CHECK(first.at("even") == 10);
+  CHECK(first.at("rare") == 10);
+  CHECK(alloc.spent() == 0);
+
+  std::map<std::string, double> probs{
+    {"even", 0.5}, {"rare", 0.01}, {"likely", 0.9}};
+  std::mt19937 random(0);
+  for (auto counts = first; !counts.empty(); counts = alloc.next(100)) {
+    for (const auto &count : counts) {
+      std::bernoulli_distribution outcome(probs.at(count.first));
+      for (size_t i = 0; i < count.second; ++i) {
+        Trial trial(count.first);
+        TrialOutput output;
+        output.preds()["x"] = outcome(random);
+        trial.status(TrialStatus::Complete::mk(std::move(output)));
+        alloc.add(trial);
+      }
+    }
+  }
+  CHECK(alloc.done());
+  CHECK(alloc.spent() == 3000);
+
+  // Predicates near 0.5 get the most trials, and the widest interval ends
+  // up narrower than with 1000 each
+  const auto &exps = alloc.experiments();
+  CHECK(exps.at("even").trials() > exps.at("likely").trials());
+  CHECK(exps.at("likely").trials() > exps.at("rare").trials());
+  CHECK(alloc.half_width() < wilson_interval(500, 1000, 0.95).second - 0.5);
+}
+
 int main(int argc, char *argv[]) {
   auto console = spdlog::stderr_color_st("log");
   auto json_log = spdlog::stderr_color_st("json");